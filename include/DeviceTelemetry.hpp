@@ -0,0 +1,135 @@
+/**
+ * @file DeviceTelemetry.hpp
+ * @brief 设备状态推送数据源
+ * @details 将LED、时间同步、堆内存、Web请求、文件系统锁、固件升级和任务状态注册到Web服务器的推送通道
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <LedController.hpp>
+#include <LittleFSController.hpp>
+#include <OtaController.hpp>
+#include <TimeManager.hpp>
+#include <WebServerController.hpp>
+#include <memory>
+
+/**
+ * @brief 设备状态推送数据源集合
+ */
+class DeviceTelemetry {
+   public:
+    /**
+     * @brief 注册全部数据源
+     * @param web 已启用推送通道的Web服务器
+     */
+    static void registerSources(WebServerController& web) {
+        web.addTelemetrySource("led", [](JsonObject obj) {
+            LedState state = LedController::getInstance().getState();
+            char color[8];
+            snprintf(
+                color, sizeof(color), "#%02x%02x%02x", state.color.r, state.color.g, state.color.b
+            );
+            obj["mode"] = ledModeToString(state.mode);
+            obj["color"] = color;
+            obj["brightness"] = state.brightness;
+        });
+
+        web.addTelemetrySource("time", [](JsonObject obj) {
+            auto& time = TimeManager::getInstance();
+            obj["status"] = syncStatusToString(time.getSyncStatus());
+            obj["lastSync"] = time.getLastSyncTimestamp();
+            obj["reliable"] = time.isTimeReliable();
+        });
+
+        web.addTelemetrySource("heap", [](JsonObject obj) {
+            obj["free"] = ESP.getFreeHeap();
+            obj["min"] = ESP.getMinFreeHeap();
+            obj["largest"] = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+            if (ESP.getPsramSize()) {
+                obj["psram"] = ESP.getFreePsram();
+            }
+        });
+
+        web.addTelemetrySource("web", [&web](JsonObject obj) {
+            AdmissionControl::Stats stats = web.getAdmissionStats();
+            obj["admitted"] = stats.admitted;
+            obj["shed"] = stats.shed;
+            obj["inFlight"] = stats.inFlight;
+            obj["inFlightBytes"] = stats.inFlightBytes;
+        });
+
+        web.addTelemetrySource("fs", [](JsonObject obj) {
+            LittleFSController::LockStats stats = LittleFSController::getInstance().getLockStats();
+            addLockWait(obj["shared"].to<JsonObject>(), stats.shared);
+            addLockWait(obj["exclusive"].to<JsonObject>(), stats.exclusive);
+        });
+
+        web.addTelemetrySource("ota", [](JsonObject obj) {
+            OtaProgress progress = OtaController::getInstance().getProgress();
+            obj["phase"] = OtaController::phaseToString(progress.phase);
+            if (progress.phase == OtaPhase::IDLE) return;
+            obj["received"] = progress.received;
+            obj["written"] = progress.written;
+            obj["total"] = progress.total;
+            obj["kbps"] = static_cast<int>(progress.kbps * 10) / 10.0f;
+            obj["elapsedMs"] = progress.elapsedMs;
+            obj["delta"] = progress.delta;
+            if (progress.resumed) {
+                obj["resumed"] = progress.resumed;
+            }
+            if ((progress.compressed || progress.delta) && progress.written > progress.received) {
+                obj["saved"] = progress.written - progress.received;
+            }
+            if (progress.phase == OtaPhase::FAILED) {
+                obj["error"] = progress.error;
+            }
+        });
+
+        web.addTelemetrySource("tasks", [](JsonObject obj) {
+            obj["count"] = uxTaskGetNumberOfTasks();
+#if configUSE_TRACE_FACILITY
+            // 各任务的剩余栈空间（字节）
+            UBaseType_t capacity = uxTaskGetNumberOfTasks() + 2;
+            auto status = std::make_unique<TaskStatus_t[]>(capacity);
+            UBaseType_t count = uxTaskGetSystemState(status.get(), capacity, nullptr);
+            JsonObject stacks = obj["stack"].to<JsonObject>();
+            for (UBaseType_t i = 0; i < count; i++) {
+                stacks[status[i].pcTaskName] = status[i].usStackHighWaterMark;
+            }
+#endif
+        });
+    }
+
+   private:
+    /**
+     * @brief 锁等待直方图，buckets按LockWaitHistogram::BUCKETS_US划分，最后一个为+Inf
+     */
+    static void addLockWait(JsonObject obj, const LockWaitHistogram::Snapshot& wait) {
+        obj["count"] = wait.count;
+        obj["timeouts"] = wait.timeouts;
+        obj["avgUs"] = wait.count ? static_cast<uint32_t>(wait.totalUs / wait.count) : 0;
+        obj["maxUs"] = wait.maxUs;
+        JsonArray buckets = obj["buckets"].to<JsonArray>();
+        for (uint32_t bucket : wait.buckets) {
+            buckets.add(bucket);
+        }
+    }
+
+    static const char* syncStatusToString(SyncStatus status) {
+        switch (status) {
+            case SyncStatus::SYNC_STATUS_RESET:
+                return "reset";
+            case SyncStatus::SYNC_STATUS_ONGOING:
+                return "ongoing";
+            case SyncStatus::SYNC_STATUS_SUCCESS:
+                return "success";
+            case SyncStatus::SYNC_STATUS_FAIL:
+                return "fail";
+        }
+        return "unknown";
+    }
+};
\ No newline at end of file
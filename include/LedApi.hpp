@@ -0,0 +1,315 @@
+/**
+ * @file LedApi.hpp
+ * @brief LED控制REST接口
+ * @details 一次请求携带颜色、亮度、模式、预设和逐像素颜色，作为一次原子状态变更应用
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <esp_log.h>
+#include <JsonArena.hpp>
+#include <LedController.hpp>
+#include <LedPresetManager.hpp>
+#include <WebServerController.hpp>
+#include <cctype>
+
+/**
+ * @brief LED控制接口
+ *
+ * - GET  /api/led 返回当前状态
+ * - POST /api/led 批量变更，支持JSON和紧凑二进制两种格式
+ *
+ * JSON格式（所有字段可选，preset最先应用，其余字段覆盖预设值）：
+ * @code
+ * {"preset":"wifi_connected","color":"#ff8800","brightness":128,"mode":"solid",
+ *  "pixels":[{"start":0,"colors":["#ff0000",[0,255,0],255]}]}
+ * @endcode
+ *
+ * 二进制格式（Content-Type: application/octet-stream）：首字节为0x4C，之后为若干条记录
+ * - 0x01 R G B：颜色
+ * - 0x02 V：亮度
+ * - 0x03 M：显示模式（LedMode枚举值）
+ * - 0x04 P：预设（LedPreset枚举值）
+ * - 0x05 起始下标(2) 数量(2) 随后数量个RGB：逐像素颜色（小端）
+ */
+class LedApi {
+    static constexpr const char* TAG = "LedApi";
+
+   public:
+    /**
+     * @brief 注册路由
+     * @param web 已初始化的Web服务器
+     */
+    static void registerRoutes(WebServerController& web) {
+        static constexpr StaticRoute routes[] = {
+            {HTTP_GET, "/api/led", handleGet, 0},
+            {HTTP_POST, "/api/led", handlePost, MAX_BODY_SIZE},
+        };
+        static constexpr StaticRouteTable table(routes);
+        static_assert(table.valid(), "Duplicate LED routes");
+
+        web.addStaticRoutes("/api/led", table);
+    }
+
+   private:
+    static constexpr size_t MAX_BODY_SIZE = 2048;  // 请求体上限
+    static constexpr size_t ARENA_SIZE = 4096;     // JSON文档内存池大小
+    static constexpr uint8_t BINARY_MAGIC = 0x4C;
+
+    enum BinaryTag : uint8_t {
+        TAG_COLOR = 0x01,
+        TAG_BRIGHTNESS = 0x02,
+        TAG_MODE = 0x03,
+        TAG_PRESET = 0x04,
+        TAG_PIXELS = 0x05
+    };
+
+    static void handleGet(AsyncWebServerRequest* request, const uint8_t*, size_t) {
+        LedState state = LedController::getInstance().getState();
+        char json[96];
+        snprintf(
+            json,
+            sizeof(json),
+            "{\"mode\":\"%s\",\"color\":\"#%02x%02x%02x\",\"brightness\":%u}",
+            ledModeToString(state.mode),
+            state.color.r,
+            state.color.g,
+            state.color.b,
+            state.brightness
+        );
+        WebServerController::sendText(request, 200, "application/json", json);
+    }
+
+    static void handlePost(AsyncWebServerRequest* request, const uint8_t* body, size_t length) {
+        if (body == nullptr || length == 0) {
+            sendError(request, "Empty body");
+            return;
+        }
+
+        LedBatch batch;
+        const char* error = request->contentType().startsWith("application/octet-stream")
+                                ? parseBinary(body, length, batch)
+                                : parseJson(body, length, batch);
+        if (error) {
+            sendError(request, error);
+            return;
+        }
+
+        LedController::getInstance().applyBatch(batch);
+        WebServerController::sendText(request, 200, "application/json", "{\"ok\":true}");
+    }
+
+    static void sendError(AsyncWebServerRequest* request, const char* error) {
+        ESP_LOGW(TAG, "Rejected LED request: %s", error);
+        char json[96];
+        snprintf(json, sizeof(json), "{\"error\":\"%s\"}", error);
+        WebServerController::sendText(request, 400, "application/json", json);
+    }
+
+    /**
+     * @brief 只保留接口关心的字段，其余内容在解析时直接跳过
+     */
+    static const JsonDocument& jsonFilter() {
+        static JsonDocument filter = [] {
+            JsonDocument doc;
+            doc["preset"] = true;
+            doc["color"] = true;
+            doc["brightness"] = true;
+            doc["mode"] = true;
+            doc["pixels"][0]["start"] = true;
+            doc["pixels"][0]["colors"] = true;
+            return doc;
+        }();
+        return filter;
+    }
+
+    static const char* parseJson(const uint8_t* body, size_t length, LedBatch& batch) {
+        // 处理器都在async_tcp任务中串行执行，内存池可以复用
+        static JsonArena<ARENA_SIZE> arena;
+        arena.reset();
+
+        JsonDocument doc(&arena);
+        DeserializationError err = deserializeJson(
+            doc,
+            reinterpret_cast<const char*>(body),
+            length,
+            DeserializationOption::Filter(jsonFilter()),
+            DeserializationOption::NestingLimit(4)
+        );
+        if (err) {
+            return err.c_str();
+        }
+
+        if (doc["preset"].is<const char*>()) {
+            LedPreset preset;
+            if (!LedPresetManager::presetFromString(doc["preset"].as<const char*>(), preset)) {
+                return "Unknown preset";
+            }
+            LedPresetManager::getInstance().fillBatch(preset, batch);
+        }
+
+        if (!doc["color"].isNull()) {
+            CRGB color;
+            if (!parseColor(doc["color"], color)) {
+                return "Invalid color";
+            }
+            batch.color = color;
+        }
+
+        if (!doc["brightness"].isNull()) {
+            int brightness = doc["brightness"] | -1;
+            if (brightness < 0 || brightness > 255) {
+                return "Invalid brightness";
+            }
+            batch.brightness = brightness;
+        }
+
+        if (!doc["mode"].isNull()) {
+            LedMode mode;
+            if (!ledModeFromString(doc["mode"].as<const char*>(), mode)) {
+                return "Unknown mode";
+            }
+            if (mode == LedMode::BLINK && !batch.blinkSequence) {
+                return "Blink mode requires a preset";
+            }
+            if (mode != LedMode::BLINK) {
+                batch.blinkSequence.reset();
+            }
+            batch.mode = mode;
+        }
+
+        for (JsonObjectConst segment : doc["pixels"].as<JsonArrayConst>()) {
+            int start = segment["start"] | 0;
+            JsonArrayConst colors = segment["colors"].as<JsonArrayConst>();
+            if (start < 0 || start + colors.size() > LED_COUNT) {
+                return "Pixel segment out of range";
+            }
+
+            LedPixelSegment pixels{static_cast<uint16_t>(start), {}};
+            pixels.colors.reserve(colors.size());
+            for (JsonVariantConst value : colors) {
+                CRGB color;
+                if (!parseColor(value, color)) {
+                    return "Invalid pixel color";
+                }
+                pixels.colors.push_back(color);
+            }
+            batch.segments.push_back(std::move(pixels));
+            clearBlink(batch);
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief 设置像素后取消之前由预设或模式带入的闪烁，否则控制任务会进入BLINK模式而忽略像素
+     */
+    static void clearBlink(LedBatch& batch) {
+        batch.blinkSequence.reset();
+        if (batch.mode == LedMode::BLINK) {
+            batch.mode.reset();
+        }
+    }
+
+    /**
+     * @brief 解析颜色，支持"#rrggbb"、[r,g,b]和0xRRGGBB整数
+     */
+    static bool parseColor(JsonVariantConst value, CRGB& color) {
+        if (value.is<const char*>()) {
+            const char* text = value.as<const char*>();
+            if (text[0] == '#') text++;
+            // strtoul会接受前导空白和正负号，如"-00001"，这里要求以十六进制数字开头
+            if (!isxdigit(static_cast<unsigned char>(text[0]))) return false;
+            char* end = nullptr;
+            uint32_t rgb = strtoul(text, &end, 16);
+            if (end - text != 6 || *end != '\0') return false;
+            color = CRGB(rgb);
+            return true;
+        }
+
+        if (value.is<JsonArrayConst>()) {
+            JsonArrayConst rgb = value.as<JsonArrayConst>();
+            if (rgb.size() != 3) return false;
+            color = CRGB(rgb[0].as<uint8_t>(), rgb[1].as<uint8_t>(), rgb[2].as<uint8_t>());
+            return true;
+        }
+
+        if (value.is<uint32_t>()) {
+            color = CRGB(value.as<uint32_t>() & 0xFFFFFF);
+            return true;
+        }
+
+        return false;
+    }
+
+    static const char* parseBinary(const uint8_t* body, size_t length, LedBatch& batch) {
+        if (body[0] != BINARY_MAGIC) {
+            return "Bad magic";
+        }
+
+        size_t pos = 1;
+        auto remaining = [&]() { return length - pos; };
+
+        while (pos < length) {
+            uint8_t tag = body[pos++];
+            switch (tag) {
+                case TAG_COLOR:
+                    if (remaining() < 3) return "Truncated color";
+                    batch.color = CRGB(body[pos], body[pos + 1], body[pos + 2]);
+                    pos += 3;
+                    break;
+
+                case TAG_BRIGHTNESS:
+                    if (remaining() < 1) return "Truncated brightness";
+                    batch.brightness = body[pos++];
+                    break;
+
+                case TAG_MODE: {
+                    if (remaining() < 1) return "Truncated mode";
+                    uint8_t mode = body[pos++];
+                    if (mode > static_cast<uint8_t>(LedMode::PIXELS)) return "Unknown mode";
+                    if (static_cast<LedMode>(mode) == LedMode::BLINK && !batch.blinkSequence) {
+                        return "Blink mode requires a preset";
+                    }
+                    if (static_cast<LedMode>(mode) != LedMode::BLINK) {
+                        batch.blinkSequence.reset();
+                    }
+                    batch.mode = static_cast<LedMode>(mode);
+                    break;
+                }
+
+                case TAG_PRESET: {
+                    if (remaining() < 1) return "Truncated preset";
+                    uint8_t preset = body[pos++];
+                    if (preset > static_cast<uint8_t>(LedPreset::OFF)) return "Unknown preset";
+                    LedPresetManager::getInstance().fillBatch(static_cast<LedPreset>(preset), batch);
+                    break;
+                }
+
+                case TAG_PIXELS: {
+                    if (remaining() < 4) return "Truncated pixels";
+                    uint16_t start = body[pos] | (body[pos + 1] << 8);
+                    uint16_t count = body[pos + 2] | (body[pos + 3] << 8);
+                    pos += 4;
+                    if (remaining() < count * 3u) return "Truncated pixels";
+                    if (start + count > LED_COUNT) return "Pixel segment out of range";
+
+                    LedPixelSegment pixels{start, {}};
+                    pixels.colors.reserve(count);
+                    for (uint16_t i = 0; i < count; i++, pos += 3) {
+                        pixels.colors.emplace_back(body[pos], body[pos + 1], body[pos + 2]);
+                    }
+                    batch.segments.push_back(std::move(pixels));
+                    clearBlink(batch);
+                    break;
+                }
+
+                default:
+                    return "Unknown record";
+            }
+        }
+
+        return nullptr;
+    }
+};
\ No newline at end of file
@@ -62,21 +62,66 @@ class LedPresetManager {
      * @param preset 预设类型
      */
     void applyPreset(LedPreset preset) {
+        LedBatch batch;
+        fillBatch(preset, batch);
+        LedController::getInstance().applyBatch(batch);
+    }
+
+    /**
+     * @brief 将预设配置写入批量变更
+     * @param preset 预设类型
+     * @param batch 目标批次，之后写入的字段会覆盖预设值
+     */
+    void fillBatch(LedPreset preset, LedBatch& batch) {
         if (!isInitialized) {
             init();
         }
 
         const auto& config = getPresetConfig(preset);
-        auto& led = LedController::getInstance();
-
-        led.setColor(config.color.r, config.color.g, config.color.b);
-        led.setBrightness(config.brightness);
+        batch.color = config.color;
+        batch.brightness = config.brightness;
 
         if (config.mode == LedMode::BLINK) {
-            led.setBlinkSequence(config.blinkSequence);
+            batch.blinkSequence = config.blinkSequence;
         } else {
-            led.setMode(config.mode);
+            batch.mode = config.mode;
+        }
+    }
+
+    /**
+     * @brief 根据名称解析预设
+     * @param name 预设名（如"wifi_connected"，不区分大小写）
+     * @param preset 解析结果
+     * @return 是否解析成功
+     */
+    static bool presetFromString(const char* name, LedPreset& preset) {
+        static constexpr struct {
+            const char* name;
+            LedPreset preset;
+        } names[] = {
+            {"system_startup", LedPreset::SYSTEM_STARTUP},
+            {"system_ready", LedPreset::SYSTEM_READY},
+            {"system_error", LedPreset::SYSTEM_ERROR},
+            {"system_update", LedPreset::SYSTEM_UPDATE},
+            {"wifi_connecting", LedPreset::WIFI_CONNECTING},
+            {"wifi_connected", LedPreset::WIFI_CONNECTED},
+            {"wifi_disconnected", LedPreset::WIFI_DISCONNECTED},
+            {"warning_normal", LedPreset::WARNING_NORMAL},
+            {"warning_urgent", LedPreset::WARNING_URGENT},
+            {"warning_sos", LedPreset::WARNING_SOS},
+            {"working", LedPreset::WORKING},
+            {"standby", LedPreset::STANDBY},
+            {"off", LedPreset::OFF},
+        };
+
+        if (!name) return false;
+        for (const auto& entry : names) {
+            if (strcasecmp(name, entry.name) == 0) {
+                preset = entry.preset;
+                return true;
+            }
         }
+        return false;
     }
 
    private:
@@ -0,0 +1,287 @@
+/**
+ * @file LedPreview.hpp
+ * @brief LED帧实时预览
+ * @details 通过二进制WebSocket将LedController渲染的帧推送到浏览器，便于远程调试
+ */
+
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <LedController.hpp>
+#include <TaskGuard.hpp>
+#include <WebServerController.hpp>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief LED帧预览推送器
+ *
+ * 帧格式（小端）：
+ * - 头部8字节：类型(1) 亮度(1) 像素数(2) 帧序号(4)
+ * - 关键帧(类型0)：RLE编码，每段为 重复次数(1) R G B
+ * - 增量帧(类型1)：变化区间列表，每段为 起始下标(2) 长度(2) 随后长度个RGB
+ *
+ * 每帧只编码一次，通过binaryAll()广播，客户端列表只由库在持有其内部锁时访问。
+ * 有新客户端连接或收到"key"文本消息时，下一次推送广播关键帧；发送队列已满的客户端丢失的增量帧
+ * 由周期关键帧修复，也可以主动请求。
+ */
+class LedPreview {
+    static constexpr const char* TAG = "LedPreview";
+
+   public:
+    using Frame = LedFrame<LED_COUNT>;
+
+    static LedPreview& getInstance() {
+        static LedPreview instance;
+        return instance;
+    }
+
+    /**
+     * @brief 初始化并启动预览推送
+     * @param web 已初始化的Web服务器
+     * @param path WebSocket路径
+     * @param fps 最大推送帧率
+     * @return 初始化是否成功
+     */
+    bool init(WebServerController& web, const char* path = "/ws/led", uint8_t fps = 10) {
+        if (isInitialized) return true;
+
+        setFps(fps);
+        socket = new AsyncWebSocket(path);
+        socket->onEvent([this](
+                            AsyncWebSocket* server,
+                            AsyncWebSocketClient* client,
+                            AwsEventType type,
+                            void* arg,
+                            uint8_t* data,
+                            size_t len
+                        ) { handleEvent(client, type, arg, data, len); });
+
+        // 先创建推送任务，失败时不注册处理器，避免留下没有数据的WebSocket端点
+        taskGuard = std::make_unique<TaskGuard>(taskHandle);
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& preview = *static_cast<LedPreview*>(param);
+                preview.previewTask();
+            },
+            "led_preview",
+            4 * 1024U,
+            this,
+            1,
+            &taskHandle
+        );
+
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create preview task");
+            taskGuard.reset();
+            delete socket;
+            socket = nullptr;
+            return false;
+        }
+
+        if (!web.addHandler(socket)) {
+            taskGuard.reset();
+            delete socket;
+            socket = nullptr;
+            return false;
+        }
+
+        isInitialized = true;
+        ESP_LOGI(TAG, "LED preview started at %s, %u fps", path, fps);
+        return true;
+    }
+
+    /**
+     * @brief 设置最大推送帧率
+     * @param fps 帧率(1-50)，LED控制任务本身为50fps
+     */
+    void setFps(uint8_t fps) {
+        fps = constrain(fps, 1, 50);
+        frameInterval = pdMS_TO_TICKS(1000 / fps);
+    }
+
+    /**
+     * @brief 设置关键帧间隔
+     * @param frames 每隔多少个推送帧强制发送一次关键帧
+     */
+    void setKeyFrameInterval(uint16_t frames) {
+        keyFrameInterval = frames;
+    }
+
+   private:
+    static constexpr uint8_t FRAME_KEY = 0;
+    static constexpr uint8_t FRAME_DELTA = 1;
+    static constexpr size_t HEADER_SIZE = 8;
+    static constexpr const char* KEY_REQUEST = "key";  // 客户端请求关键帧的消息
+
+    LedPreview() {}
+
+    LedPreview(const LedPreview&) = delete;
+    LedPreview& operator=(const LedPreview&) = delete;
+
+    /**
+     * @brief 处理连接事件和客户端消息
+     * @note 在async_tcp任务中调用，与客户端列表的修改在同一任务，可以安全地清理多余的客户端
+     */
+    void handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+        if (type == WS_EVT_CONNECT) {
+            socket->cleanupClients();
+            clientCount++;
+            keyRequested = true;
+        } else if (type == WS_EVT_DISCONNECT) {
+            clientCount--;
+        } else if (type == WS_EVT_DATA) {
+            auto* info = static_cast<AwsFrameInfo*>(arg);
+            bool whole = info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT;
+            if (whole && len == strlen(KEY_REQUEST) && memcmp(data, KEY_REQUEST, len) == 0) {
+                keyRequested = true;
+            }
+        }
+    }
+
+    void previewTask() {
+        TickType_t lastWakeTime = xTaskGetTickCount();
+
+        while (true) {
+            publishFrame();
+            vTaskDelayUntil(&lastWakeTime, frameInterval);
+        }
+    }
+
+    void publishFrame() {
+        if (clientCount.load() == 0) {
+            hasPrevious = false;
+            return;
+        }
+
+        // 控制任务没有渲染新帧时，acquireFrame返回nullptr，直接复用上一帧
+        const Frame* frame = LedController::getInstance().acquireFrame();
+        bool changed = frame != nullptr && (!hasPrevious || !sameFrame(*frame, previous));
+        if (frame == nullptr) {
+            if (!hasPrevious) {
+                return;  // 尚未拿到任何帧，关键帧请求留到下次
+            }
+            frame = &previous;
+        }
+
+        bool key = keyRequested.exchange(false);
+        if (!changed && !key) {
+            return;
+        }
+
+        AsyncWebSocketSharedBuffer buffer;
+        if (key || !hasPrevious || ++framesSinceKey >= keyFrameInterval) {
+            buffer = encodeKeyFrame(*frame);
+            framesSinceKey = 0;
+        } else {
+            buffer = encodeDeltaFrame(*frame, previous);
+        }
+        socket->binaryAll(buffer);
+
+        if (frame != &previous) {
+            previous = *frame;
+            hasPrevious = true;
+        }
+    }
+
+    static bool sameFrame(const Frame& a, const Frame& b) {
+        return a.brightness == b.brightness && memcmp(a.pixels, b.pixels, sizeof(a.pixels)) == 0;
+    }
+
+    static uint8_t* writeHeader(uint8_t* out, uint8_t type, const Frame& frame) {
+        *out++ = type;
+        *out++ = frame.brightness;
+        *out++ = LED_COUNT & 0xFF;
+        *out++ = (LED_COUNT >> 8) & 0xFF;
+        for (int i = 0; i < 4; i++) {
+            *out++ = (frame.sequence >> (i * 8)) & 0xFF;
+        }
+        return out;
+    }
+
+    static uint8_t* writeColor(uint8_t* out, const CRGB& color) {
+        *out++ = color.r;
+        *out++ = color.g;
+        *out++ = color.b;
+        return out;
+    }
+
+    /**
+     * @brief 编码关键帧（RLE）
+     */
+    static AsyncWebSocketSharedBuffer encodeKeyFrame(const Frame& frame) {
+        auto buffer = std::make_shared<std::vector<uint8_t>>(HEADER_SIZE + LED_COUNT * 4);
+        uint8_t* out = writeHeader(buffer->data(), FRAME_KEY, frame);
+
+        size_t i = 0;
+        while (i < LED_COUNT) {
+            size_t run = 1;
+            while (i + run < LED_COUNT && run < 255 && frame.pixels[i + run] == frame.pixels[i]) {
+                run++;
+            }
+            *out++ = run;
+            out = writeColor(out, frame.pixels[i]);
+            i += run;
+        }
+
+        buffer->resize(out - buffer->data());
+        return buffer;
+    }
+
+    /**
+     * @brief 编码增量帧（仅包含变化的像素区间）
+     */
+    static AsyncWebSocketSharedBuffer encodeDeltaFrame(const Frame& frame, const Frame& base) {
+        auto buffer = std::make_shared<std::vector<uint8_t>>(HEADER_SIZE + LED_COUNT * 7);
+        uint8_t* out = writeHeader(buffer->data(), FRAME_DELTA, frame);
+
+        size_t i = 0;
+        while (i < LED_COUNT) {
+            if (frame.pixels[i] == base.pixels[i]) {
+                i++;
+                continue;
+            }
+
+            // 向后扩展区间，单个未变化像素也并入区间以减少区间头开销
+            size_t end = i + 1;
+            while (end < LED_COUNT) {
+                if (frame.pixels[end] != base.pixels[end]) {
+                    end++;
+                } else if (end + 1 < LED_COUNT && frame.pixels[end + 1] != base.pixels[end + 1]) {
+                    end += 2;
+                } else {
+                    break;
+                }
+            }
+
+            size_t length = end - i;
+            *out++ = i & 0xFF;
+            *out++ = (i >> 8) & 0xFF;
+            *out++ = length & 0xFF;
+            *out++ = (length >> 8) & 0xFF;
+            for (size_t j = i; j < end; j++) {
+                out = writeColor(out, frame.pixels[j]);
+            }
+            i = end;
+        }
+
+        buffer->resize(out - buffer->data());
+        return buffer;
+    }
+
+    bool isInitialized = false;
+    AsyncWebSocket* socket = nullptr;  // 由AsyncWebServer持有
+    TickType_t frameInterval = pdMS_TO_TICKS(100);
+    uint16_t keyFrameInterval = 50;  // 强制关键帧间隔（推送帧数）
+    uint16_t framesSinceKey = 0;
+    Frame previous = {};  // 上一次推送的帧，仅预览任务访问
+    bool hasPrevious = false;
+    std::atomic<bool> keyRequested{false};  // 下次推送是否广播关键帧
+    std::atomic<size_t> clientCount{0};     // 当前连接的客户端数
+    TaskHandle_t taskHandle = nullptr;
+    std::unique_ptr<TaskGuard> taskGuard;
+};
\ No newline at end of file
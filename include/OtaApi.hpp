@@ -0,0 +1,202 @@
+/**
+ * @file OtaApi.hpp
+ * @brief 固件升级接口
+ * @details 上传的数据到达即写入下一个OTA分区，不缓存完整固件
+ */
+
+#pragma once
+
+#include <esp_log.h>
+#include <FsImageUpdater.hpp>
+#include <LedPresetManager.hpp>
+#include <OtaController.hpp>
+#include <type_traits>
+#include <WebServerController.hpp>
+
+/**
+ * @brief 固件升级接口
+ *
+ * POST /api/ota 上传固件，两种方式均可：
+ * - 原始请求体：curl --data-binary @firmware.bin -H "Content-Type: application/octet-stream"
+ * - 表单上传：curl -F "firmware=@firmware.bin"
+ *
+ * 固件可以先用gzip压缩（gzip -9 firmware.bin），设备按魔数自动识别并边解压边写入。
+ * 也可以上传相对当前运行固件的差分补丁（tools/ota_delta.py生成，默认已gzip压缩），设备读取运行分区还原新固件。
+ * 可选请求头 X-Firmware-SHA256 携带固件（未压缩）的SHA-256，写入完成后校验，不一致则不切换分区。
+ * 升级成功后返回结果并在1秒后重启。进度通过推送通道的"ota"字段上报。
+ *
+ * POST /api/ota/pull 让设备自行从HTTP服务器下载固件，请求体：{"url": "...", "sha256": "..."}（sha256可选）。
+ * 下载中断后再次提交同样的请求即从断点继续，完成后自动重启。
+ *
+ * POST /api/ota/fs 上传LittleFS分区镜像（pio run -t buildfs生成的littlefs.bin，可gzip压缩），
+ * 上传方式和校验头与固件相同，写入后重新挂载文件系统，不重启。
+ */
+class OtaApi {
+    static constexpr const char* TAG = "OtaApi";
+
+   public:
+    /**
+     * @brief 注册路由
+     * @param web 已初始化的Web服务器
+     * @param path 接口路径
+     */
+    static void registerRoutes(WebServerController& web, const char* path = "/api/ota") {
+        // 同一时间只允许一个升级，请求体直接写入flash，不计入在途字节
+        web.setRouteLimit(path, 1, 0, true);
+        // 上传路由会匹配所有子路径，拉取路由必须先注册
+        String pullPath = String(path) + "/pull";
+        String fsPath = String(path) + "/fs";
+        web.addBodyHandler(pullPath.c_str(), HTTP_POST, handlePull, MAX_PULL_BODY_SIZE);
+        web.addUploadHandler(
+            fsPath.c_str(), HTTP_POST, handleComplete<FsImageUpdater>, handleChunk<FsImageUpdater>
+        );
+        web.addUploadHandler(path, HTTP_POST, handleComplete<OtaController>, handleChunk<OtaController>);
+    }
+
+   private:
+    static constexpr const char* SHA256_HEADER = "X-Firmware-SHA256";
+    static constexpr size_t MAX_PULL_BODY_SIZE = 512;
+
+    static void handlePull(AsyncWebServerRequest* request, const uint8_t* body, size_t length) {
+        JsonDocument doc;
+        if (body == nullptr || deserializeJson(doc, body, length) || !doc["url"].is<const char*>()) {
+            JsonDocument error;
+            error["error"] = "Expected {\"url\": \"...\"}";
+            WebServerController::sendJson(request, std::move(error), 400);
+            return;
+        }
+
+        auto& ota = OtaController::getInstance();
+        JsonDocument result;
+        if (!ota.pull(doc["url"], doc["sha256"] | static_cast<const char*>(nullptr))) {
+            OtaProgress progress = ota.getProgress();
+            bool failed = progress.phase == OtaPhase::FAILED;
+            result["error"] = failed ? progress.error : "Update in progress";
+            WebServerController::sendJson(request, std::move(result), failed ? 400 : 409);
+            return;
+        }
+
+        LedPresetManager::getInstance().applyPreset(LedPreset::SYSTEM_UPDATE);
+        result["ok"] = true;
+        WebServerController::sendJson(request, std::move(result), 202);
+    }
+
+    // 当前上传所属的请求；路由并发限制为1，处理器都在async_tcp任务中执行
+    static inline AsyncWebServerRequest* uploader = nullptr;
+    // 当前上传是否已成功开始写入
+    static inline bool uploadStarted = false;
+
+    /**
+     * @brief 上传数据块，Updater为OtaController或FsImageUpdater
+     */
+    template <typename Updater>
+    static void handleChunk(
+        AsyncWebServerRequest* request,
+        const uint8_t* data,
+        size_t length,
+        size_t index,
+        size_t total,
+        bool final
+    ) {
+        auto& ota = Updater::getInstance();
+        if (index == 0) {
+            const char* sha256 = nullptr;
+            if (request->hasHeader(SHA256_HEADER)) {
+                sha256 = request->getHeader(SHA256_HEADER)->value().c_str();
+            }
+            uploader = request;
+            uploadStarted = false;
+            WebServerController::getInstance().onDisconnect(request, [request]() {
+                handleDisconnect<Updater>(request);
+            });
+            if (!ota.begin(total, sha256)) {
+                return;
+            }
+            uploadStarted = true;
+            LedPresetManager::getInstance().applyPreset(LedPreset::SYSTEM_UPDATE);
+        }
+
+        if (length > 0 && !ota.write(data, length)) {
+            return;
+        }
+        if (final) {
+            ota.finish();
+        }
+    }
+
+    /**
+     * @brief 连接断开；上传中途断开时handleComplete不会被调用，在这里放弃写入并恢复状态
+     */
+    template <typename Updater>
+    static void handleDisconnect(AsyncWebServerRequest* request) {
+        if (uploader != request) {
+            return;
+        }
+        uploader = nullptr;
+        if (!uploadStarted) {
+            return;
+        }
+        uploadStarted = false;
+
+        // 文件系统镜像升级放弃时会尝试重新挂载
+        auto& ota = Updater::getInstance();
+        if (ota.getProgress().phase == OtaPhase::RECEIVING) {
+            ota.abort("Client disconnected");
+            LedPresetManager::getInstance().applyPreset(LedPreset::SYSTEM_ERROR);
+        }
+    }
+
+    /**
+     * @brief 上传结束，返回结果
+     */
+    template <typename Updater>
+    static void handleComplete(AsyncWebServerRequest* request) {
+        JsonDocument doc;
+        if (uploader != request) {
+            doc["error"] = "Empty upload";
+            WebServerController::sendJson(request, std::move(doc), 400);
+            return;
+        }
+        uploader = nullptr;
+        uploadStarted = false;
+
+        auto& ota = Updater::getInstance();
+        OtaProgress progress = ota.getProgress();
+        if (progress.phase == OtaPhase::RECEIVING) {
+            ota.abort("Incomplete upload");
+            progress = ota.getProgress();
+        }
+
+        if (progress.phase != OtaPhase::DONE) {
+            LedPresetManager::getInstance().applyPreset(LedPreset::SYSTEM_ERROR);
+            doc["error"] = progress.error;
+            if (progress.fsUnusable) {
+                doc["fsUnusable"] = true;
+            }
+            WebServerController::sendJson(request, std::move(doc), 400);
+            return;
+        }
+
+        doc["ok"] = true;
+        doc["size"] = progress.written;
+        if (progress.delta) {
+            doc["delta"] = true;
+        }
+        if ((progress.compressed || progress.delta) && progress.written > progress.received) {
+            doc["received"] = progress.received;
+            doc["saved"] = progress.written - progress.received;
+        }
+        doc["sha256"] = ota.getSha256();
+        doc["elapsedMs"] = progress.elapsedMs;
+        doc["kbps"] = progress.kbps;
+        WebServerController::sendJson(request, std::move(doc));
+
+        if constexpr (std::is_same_v<Updater, OtaController>) {
+            ESP_LOGI(TAG, "Firmware update complete, restarting");
+            ota.scheduleRestart();
+        } else {
+            ESP_LOGI(TAG, "Filesystem update complete");
+            LedPresetManager::getInstance().applyPreset(LedPreset::SYSTEM_READY);
+        }
+    }
+};
\ No newline at end of file
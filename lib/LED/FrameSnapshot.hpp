@@ -0,0 +1,73 @@
+/**
+ * @file FrameSnapshot.hpp
+ * @brief LED帧快照的无锁三缓冲
+ * @details 渲染任务写入、单个读取者取走最新帧，双方都不需要持有LED互斥锁
+ */
+
+#pragma once
+
+#include <FastLED.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief LED帧数据
+ */
+template <size_t N>
+struct LedFrame {
+    uint32_t sequence;   // 帧序号，单调递增
+    uint8_t brightness;  // 全局亮度
+    CRGB pixels[N];      // 像素颜色（未应用亮度）
+};
+
+/**
+ * @brief 单写单读的三缓冲帧快照
+ *
+ * 写入者始终写后台缓冲区，提交时与中间缓冲区交换；读取者获取时将前台缓冲区与中间缓冲区交换。
+ * 读取者拿到的帧在下次acquire()之前不会被写入者修改，因此可以原地读取而无需拷贝。
+ */
+template <size_t N>
+class FrameSnapshot {
+   public:
+    using Frame = LedFrame<N>;
+
+    /**
+     * @brief 获取可写入的后台帧（仅限写入者调用）
+     */
+    Frame& back() {
+        return frames[backIndex];
+    }
+
+    /**
+     * @brief 发布后台帧（仅限写入者调用）
+     */
+    void publish() {
+        frames[backIndex].sequence = ++sequence;
+        uint8_t previous = middle.exchange(backIndex | FRESH_BIT, std::memory_order_acq_rel);
+        backIndex = previous & INDEX_MASK;
+    }
+
+    /**
+     * @brief 获取最新发布的帧（仅限读取者调用）
+     * @return 自上次获取后没有新帧时返回nullptr
+     */
+    const Frame* acquire() {
+        if (!(middle.load(std::memory_order_acquire) & FRESH_BIT)) {
+            return nullptr;
+        }
+        uint8_t previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & INDEX_MASK;
+        return &frames[frontIndex];
+    }
+
+   private:
+    static constexpr uint8_t FRESH_BIT = 0x80;
+    static constexpr uint8_t INDEX_MASK = 0x03;
+
+    Frame frames[3] = {};
+    uint8_t backIndex = 0;           // 写入者私有
+    uint8_t frontIndex = 1;          // 读取者私有
+    std::atomic<uint8_t> middle{2};  // 交换槽位，最高位表示有新帧
+    uint32_t sequence = 0;
+};
\ No newline at end of file
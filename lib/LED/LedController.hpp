@@ -11,7 +11,9 @@
 #include <freertos/queue.h>
 #include <freertos/semphr.h>
 #include <freertos/task.h>
+#include <optional>
 #include <vector>
+#include "FrameSnapshot.hpp"
 
 #define LED_PIN 48
 #define LED_COUNT 1
@@ -24,9 +26,58 @@ enum class LedMode {
     SOLID,      // 单色常亮
     BLINK,      // 自定义闪烁
     BREATHING,  // 呼吸效果
-    RAINBOW     // 彩虹色渐变
+    RAINBOW,    // 彩虹色渐变
+    PIXELS      // 逐像素自定义颜色
 };
 
+/**
+ * @brief 获取显示模式名称
+ * @param mode 显示模式
+ * @return 小写模式名
+ */
+inline const char* ledModeToString(LedMode mode) {
+    switch (mode) {
+        case LedMode::OFF:
+            return "off";
+        case LedMode::SOLID:
+            return "solid";
+        case LedMode::BLINK:
+            return "blink";
+        case LedMode::BREATHING:
+            return "breathing";
+        case LedMode::RAINBOW:
+            return "rainbow";
+        case LedMode::PIXELS:
+            return "pixels";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 根据名称解析显示模式
+ * @param name 模式名（不区分大小写）
+ * @param mode 解析结果
+ * @return 是否解析成功
+ */
+inline bool ledModeFromString(const char* name, LedMode& mode) {
+    static constexpr LedMode modes[] = {
+        LedMode::OFF,
+        LedMode::SOLID,
+        LedMode::BLINK,
+        LedMode::BREATHING,
+        LedMode::RAINBOW,
+        LedMode::PIXELS
+    };
+    if (!name) return false;
+    for (LedMode candidate : modes) {
+        if (strcasecmp(name, ledModeToString(candidate)) == 0) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief 闪烁序列中的单个步骤
  */
@@ -44,6 +95,35 @@ struct BlinkSequence {
     bool repeat;                   // 是否循环播放
 };
 
+/**
+ * @brief 一段连续像素的颜色
+ */
+struct LedPixelSegment {
+    uint16_t start;            // 起始像素下标
+    std::vector<CRGB> colors;  // 从start开始的像素颜色
+};
+
+/**
+ * @brief 批量LED状态变更
+ * @details 未设置的字段保持不变，整个批次由控制任务一次性应用
+ */
+struct LedBatch {
+    std::optional<CRGB> color;                   // 颜色
+    std::optional<uint8_t> brightness;           // 亮度
+    std::optional<LedMode> mode;                 // 显示模式
+    std::optional<BlinkSequence> blinkSequence;  // 闪烁序列，设置后进入BLINK模式
+    std::vector<LedPixelSegment> segments;       // 逐像素颜色，设置后默认进入PIXELS模式
+};
+
+/**
+ * @brief LED当前状态
+ */
+struct LedState {
+    CRGB color;          // 当前颜色
+    uint8_t brightness;  // 最大亮度
+    LedMode mode;        // 显示模式
+};
+
 /**
  * @brief LED控制命令类型
  */
@@ -51,7 +131,8 @@ enum class LedCommandType {
     SET_COLOR,          // 设置颜色
     SET_BRIGHTNESS,     // 设置亮度
     SET_MODE,           // 设置显示模式
-    SET_BLINK_SEQUENCE  // 设置闪烁序列
+    SET_BLINK_SEQUENCE,  // 设置闪烁序列
+    APPLY_BATCH          // 应用批量变更
 };
 
 /**
@@ -68,6 +149,7 @@ struct LedCommand {
         uint8_t brightness;
         LedMode mode;
         BlinkSequence* blinkSequence;  // 使用指针避免union大小问题
+        LedBatch* batch;               // 由控制任务释放
     } data;
 };
 
@@ -145,6 +227,51 @@ class LedController {
         xQueueSend(cmdQueue, &cmd, portMAX_DELAY);
     }
 
+    /**
+     * @brief 批量应用状态变更
+     * @param batch 变更内容，颜色、亮度、模式和像素在同一帧内生效
+     */
+    void applyBatch(const LedBatch& batch) {
+        if (!isInitialized) return;
+
+        LedCommand cmd;
+        cmd.type = LedCommandType::APPLY_BATCH;
+        cmd.data.batch = new LedBatch(batch);
+        xQueueSend(cmdQueue, &cmd, portMAX_DELAY);
+    }
+
+    /**
+     * @brief 获取当前状态
+     * @return 已被控制任务应用的状态（队列中未处理的命令不计入）
+     */
+    LedState getState() {
+        LedState state{currentColor, maxBrightness, currentMode};
+        if (!isInitialized) return state;
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        state = {currentColor, maxBrightness, currentMode};
+        xSemaphoreGive(mutex);
+        return state;
+    }
+
+    /**
+     * @brief 获取最新渲染的帧
+     * @return 自上次调用后没有新帧时返回nullptr
+     * @note 只允许一个读取者调用；返回的帧在下次调用前保持有效，读取时无需加锁
+     */
+    const LedFrame<LED_COUNT>* acquireFrame() {
+        return snapshot.acquire();
+    }
+
+    /**
+     * @brief 控制任务是否仍在运行
+     * @param maxSilenceMs 允许的最长无心跳时间
+     * @return 控制任务在maxSilenceMs内完成过一帧时返回true
+     */
+    bool isAlive(uint32_t maxSilenceMs = 500) const {
+        return isInitialized && heartbeatMs != 0 && millis() - heartbeatMs <= maxSilenceMs;
+    }
+
    private:
     LedController()
         : isInitialized(false), currentMode(LedMode::OFF), currentStepIndex(0), stepStartTime(0) {
@@ -195,6 +322,7 @@ class LedController {
             }
 
             updateLedEffect();
+            heartbeatMs = millis();
             vTaskDelayUntil(&lastWakeTime, frequency);
         }
     }
@@ -230,11 +358,51 @@ class LedController {
                 stepStartTime = millis();
                 currentMode = LedMode::BLINK;
                 break;
+
+            case LedCommandType::APPLY_BATCH:
+                applyBatchLocked(*cmd.data.batch);
+                delete cmd.data.batch;
+                break;
         }
 
         xSemaphoreGive(mutex);
     }
 
+    /**
+     * @brief 应用批量变更，调用时需持有mutex
+     */
+    void applyBatchLocked(LedBatch& batch) {
+        if (batch.color) {
+            currentColor = *batch.color;
+        }
+        if (batch.brightness) {
+            maxBrightness = *batch.brightness;
+        }
+
+        for (const auto& segment : batch.segments) {
+            for (size_t i = 0; i < segment.colors.size(); i++) {
+                size_t index = segment.start + i;
+                if (index >= LED_COUNT) break;
+                pixels[index] = segment.colors[i];
+            }
+        }
+
+        if (batch.blinkSequence) {
+            clearBlinkSequence();
+            currentBlinkSequence = new BlinkSequence(std::move(*batch.blinkSequence));
+            currentStepIndex = 0;
+            stepStartTime = millis();
+            currentMode = LedMode::BLINK;
+        } else if (batch.mode || !batch.segments.empty()) {
+            currentMode = batch.mode.value_or(LedMode::PIXELS);
+            effectStartTime = millis();
+            hue = 0;
+            if (currentMode != LedMode::BLINK) {
+                clearBlinkSequence();
+            }
+        }
+    }
+
     void updateLedEffect() {
         xSemaphoreTake(mutex, portMAX_DELAY);
 
@@ -260,10 +428,21 @@ class LedController {
             case LedMode::RAINBOW:
                 updateRainbowEffect();
                 break;
+
+            case LedMode::PIXELS:
+                memcpy(leds, pixels, sizeof(pixels));
+                FastLED.setBrightness(maxBrightness);
+                break;
         }
 
         FastLED.show();
         xSemaphoreGive(mutex);
+
+        // leds只由控制任务写入，快照在锁外发布
+        auto& frame = snapshot.back();
+        frame.brightness = FastLED.getBrightness();
+        memcpy(frame.pixels, leds, sizeof(frame.pixels));
+        snapshot.publish();
     }
 
     /**
@@ -326,9 +505,12 @@ class LedController {
     LedMode currentMode;
     uint32_t effectStartTime;
     uint8_t hue;
+    CRGB pixels[LED_COUNT];  // PIXELS模式下的像素颜色
     QueueHandle_t cmdQueue;
     SemaphoreHandle_t mutex;
     TaskHandle_t controlTaskHandle;
+    volatile uint32_t heartbeatMs = 0;  // 控制任务最近一帧的时间
+    FrameSnapshot<LED_COUNT> snapshot;  // 供预览等读取者使用的帧快照
 
     // 闪烁序列相关
     BlinkSequence* currentBlinkSequence = nullptr;
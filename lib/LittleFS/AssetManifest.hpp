@@ -0,0 +1,281 @@
+/**
+ * @file AssetManifest.hpp
+ * @brief Web资源目录的内存清单
+ * @details 挂载时遍历一次资源目录，之后存在性、大小和MIME类型查询不访问flash
+ */
+
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <vector>
+#include "MimeTypes.hpp"
+
+/**
+ * @brief Web资源清单
+ *
+ * 每个文件或目录一项，以完整路径的64位FNV-1a哈希为键，按键排序后二分查找，不保存路径字符串。
+ * "x.gz"不单独建项，而是记在"x"项上（x本身可以不存在），查询"x"时可得知是否有压缩版本。
+ *
+ * 由LittleFSController在挂载时构建，并在通过它写入、追加、删除文件后更新；
+ * 直接通过LittleFS修改资源目录的内容需要重新挂载才能反映到清单中。
+ */
+class AssetManifest {
+   public:
+    static constexpr const char* GZIP_SUFFIX = ".gz";
+
+    /**
+     * @brief 查询结果
+     */
+    struct Info {
+        size_t size;           // 文件大小，目录为0
+        time_t mtime;          // 修改时间
+        const char* mimeType;  // MIME类型
+        uint32_t etag;         // 由路径、大小和修改时间计算的弱校验值，可用作ETag
+        bool isDirectory;      // 是否为目录
+        bool hasGzip;          // 是否有".gz"压缩版本
+        size_t gzipSize;       // 压缩版本的大小
+    };
+
+    /**
+     * @param root 资源目录，以'/'开头，不以'/'结尾
+     */
+    explicit AssetManifest(const char* root) : root(root), rootLength(strlen(root)) {}
+
+    ~AssetManifest() {
+        vSemaphoreDelete(mutex);
+    }
+
+    AssetManifest(const AssetManifest&) = delete;
+    AssetManifest& operator=(const AssetManifest&) = delete;
+
+    /**
+     * @brief 路径是否在资源目录中（包括资源目录本身）
+     */
+    bool covers(const char* path) const {
+        return strncmp(path, root, rootLength) == 0 && (path[rootLength] == '\0' || path[rootLength] == '/');
+    }
+
+    /**
+     * @brief 清单是否可用，未构建或文件系统未挂载时查询应回退到文件系统
+     */
+    bool isReady() const {
+        return ready;
+    }
+
+    /**
+     * @brief 清空并标记为不可用
+     */
+    void clear() {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        entries.clear();
+        entries.shrink_to_fit();
+        ready = false;
+        xSemaphoreGive(mutex);
+    }
+
+    /**
+     * @brief 用一组文件替换清单内容并标记为可用
+     * @param build 构建函数，对每个文件或目录调用add(path, size, mtime, isDirectory)
+     */
+    template <typename Fn>
+    void rebuild(Fn&& build) {
+        std::vector<Entry> fresh;
+        build([&](const char* path, size_t size, time_t mtime, bool isDirectory) {
+            fresh.push_back(makeEntry(path, size, mtime, isDirectory));
+        });
+
+        // 排序后合并同一路径的项（"x"和"x.gz"）
+        std::sort(fresh.begin(), fresh.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+        size_t count = 0;
+        for (size_t i = 0; i < fresh.size(); i++) {
+            if (count > 0 && fresh[count - 1].key == fresh[i].key) {
+                merge(fresh[count - 1], fresh[i]);
+            } else {
+                fresh[count++] = fresh[i];
+            }
+        }
+        fresh.resize(count);
+        fresh.shrink_to_fit();
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        entries.swap(fresh);
+        ready = true;
+        xSemaphoreGive(mutex);
+    }
+
+    /**
+     * @brief 文件被修改后更新对应项
+     * @param path 文件路径
+     * @param exists 修改后是否存在
+     * @param size 文件大小
+     * @param mtime 修改时间
+     * @param isDirectory 是否为目录
+     */
+    void update(const char* path, bool exists, size_t size, time_t mtime, bool isDirectory) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        if (ready) {
+            apply(path, exists, size, mtime, isDirectory);
+            // 新文件所在的目录可能是写入时自动创建的
+            char parent[MAX_PARENT_LENGTH];
+            size_t length = strlen(path);
+            while (exists && length > rootLength) {
+                while (length > 0 && path[length - 1] != '/') {
+                    length--;
+                }
+                if (length == 0 || --length < rootLength || length >= sizeof(parent)) {
+                    break;
+                }
+                memcpy(parent, path, length);
+                parent[length] = '\0';
+                apply(parent, true, 0, mtime, true);
+            }
+        }
+        xSemaphoreGive(mutex);
+    }
+
+    /**
+     * @brief 查询文件或目录
+     * @param path 路径
+     * @param info 输出查询结果
+     * @return 是否存在
+     */
+    bool lookup(const char* path, Info& info) const {
+        size_t length = strlen(path);
+        while (length > 1 && path[length - 1] == '/') {
+            length--;
+        }
+        bool gzip = isGzip(path, length);
+
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        const Entry* entry = find(entries, hash(path, gzip ? length - strlen(GZIP_SUFFIX) : length));
+        bool found = entry && (gzip ? (entry->flags & FLAG_GZIP) : (entry->flags & (FLAG_FILE | FLAG_DIRECTORY)));
+        if (found) {
+            info.size = gzip ? entry->gzipSize : entry->size;
+            info.mtime = entry->mtime;
+            info.mimeType = gzip ? MimeTypes::lookup(path) : entry->mimeType;
+            info.etag = static_cast<uint32_t>(entry->key ^ (entry->key >> 32)) ^ (info.size * 2654435761u) ^ entry->mtime;
+            info.isDirectory = !gzip && (entry->flags & FLAG_DIRECTORY);
+            info.hasGzip = !gzip && (entry->flags & FLAG_GZIP);
+            info.gzipSize = info.hasGzip ? entry->gzipSize : 0;
+        }
+        xSemaphoreGive(mutex);
+        return found;
+    }
+
+    /**
+     * @brief 清单项数
+     */
+    size_t size() const {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        size_t count = entries.size();
+        xSemaphoreGive(mutex);
+        return count;
+    }
+
+   private:
+    static constexpr size_t MAX_PARENT_LENGTH = 256;
+    static constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    // 清单项标志
+    static constexpr uint8_t FLAG_FILE = 0x01;       // 文件存在
+    static constexpr uint8_t FLAG_GZIP = 0x02;       // 压缩版本存在
+    static constexpr uint8_t FLAG_DIRECTORY = 0x04;  // 是目录
+
+    struct Entry {
+        uint64_t key;          // 路径哈希
+        uint32_t size;         // 文件大小
+        uint32_t gzipSize;     // 压缩版本大小
+        uint32_t mtime;        // 修改时间
+        const char* mimeType;  // MIME类型
+        uint8_t flags;         // 标志
+    };
+
+    static uint64_t hash(const char* path, size_t length) {
+        uint64_t value = FNV_OFFSET;
+        for (size_t i = 0; i < length; i++) {
+            value = (value ^ static_cast<uint8_t>(path[i])) * FNV_PRIME;
+        }
+        return value;
+    }
+
+    static bool isGzip(const char* path, size_t length) {
+        size_t suffixLength = strlen(GZIP_SUFFIX);
+        return length > suffixLength && memcmp(path + length - suffixLength, GZIP_SUFFIX, suffixLength) == 0;
+    }
+
+    static const Entry* find(const std::vector<Entry>& list, uint64_t key) {
+        auto it = std::lower_bound(list.begin(), list.end(), key, [](const Entry& e, uint64_t k) { return e.key < k; });
+        return it != list.end() && it->key == key ? &*it : nullptr;
+    }
+
+    /**
+     * @brief 由一个文件或目录生成清单项
+     */
+    static Entry makeEntry(const char* path, size_t size, time_t mtime, bool isDirectory) {
+        size_t length = strlen(path);
+        bool gzip = !isDirectory && isGzip(path, length);
+        Entry entry{hash(path, gzip ? length - strlen(GZIP_SUFFIX) : length), 0, 0, static_cast<uint32_t>(mtime), nullptr, 0};
+        if (gzip) {
+            entry.flags = FLAG_GZIP;
+            entry.gzipSize = size;
+        } else if (isDirectory) {
+            entry.flags = FLAG_DIRECTORY;
+        } else {
+            entry.flags = FLAG_FILE;
+            entry.size = size;
+            entry.mimeType = MimeTypes::lookup(path);
+        }
+        return entry;
+    }
+
+    /**
+     * @brief 把同一路径的另一项合并到target
+     */
+    static void merge(Entry& target, const Entry& other) {
+        if (other.flags & FLAG_GZIP) {
+            target.gzipSize = other.gzipSize;
+        }
+        if (other.flags & (FLAG_FILE | FLAG_DIRECTORY)) {
+            target.size = other.size;
+            target.mimeType = other.mimeType;
+            target.flags &= FLAG_GZIP;
+        }
+        target.mtime = std::max(target.mtime, other.mtime);
+        target.flags |= other.flags;
+    }
+
+    /**
+     * @brief 添加、修改或删除一项，保持有序
+     */
+    void apply(const char* path, bool exists, size_t size, time_t mtime, bool isDirectory) {
+        Entry update = makeEntry(path, size, mtime, isDirectory);
+        auto it = std::lower_bound(entries.begin(), entries.end(), update.key, [](const Entry& e, uint64_t k) {
+            return e.key < k;
+        });
+        bool found = it != entries.end() && it->key == update.key;
+
+        if (exists) {
+            if (found) {
+                merge(*it, update);
+            } else {
+                entries.insert(it, update);
+            }
+        } else if (found) {
+            it->flags &= ~update.flags;
+            if (it->flags == 0) {
+                entries.erase(it);
+            }
+        }
+    }
+
+    const char* root;                                   // 资源目录
+    size_t rootLength;                                  // 资源目录路径长度
+    std::vector<Entry> entries;                         // 按键排序的清单项
+    bool ready = false;                                 // 清单是否可用
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 互斥锁
+};
\ No newline at end of file
@@ -0,0 +1,188 @@
+/**
+ * @file FsRwLock.hpp
+ * @brief 带超时的读写锁和锁等待时间直方图
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <atomic>
+
+/**
+ * @brief 读写锁
+ *
+ * - 多个读者可以同时持有共享锁，写者独占
+ * - 写者优先：有写者等待时新来的读者在闸门处排队，避免写者饿死
+ * - 所有加锁操作都支持超时
+ *
+ * @note 独占锁必须由加锁的任务解锁（闸门是互斥锁）；共享锁可以在不同任务中加锁和解锁
+ */
+class FsRwLock {
+   public:
+    FsRwLock() = default;
+
+    ~FsRwLock() {
+        vSemaphoreDelete(turnstile);
+        vSemaphoreDelete(guard);
+        vSemaphoreDelete(resource);
+    }
+
+    FsRwLock(const FsRwLock&) = delete;
+    FsRwLock& operator=(const FsRwLock&) = delete;
+
+    /**
+     * @brief 加共享锁
+     * @param timeout 超时（tick）
+     * @return 是否成功
+     */
+    bool lockShared(TickType_t timeout = portMAX_DELAY) {
+        TickType_t start = xTaskGetTickCount();
+        if (xSemaphoreTake(turnstile, timeout) != pdTRUE) {
+            return false;
+        }
+        xSemaphoreGive(turnstile);
+
+        if (xSemaphoreTake(guard, remaining(start, timeout)) != pdTRUE) {
+            return false;
+        }
+        // 第一个读者代表所有读者占用资源
+        if (readers == 0 && xSemaphoreTake(resource, remaining(start, timeout)) != pdTRUE) {
+            xSemaphoreGive(guard);
+            return false;
+        }
+        readers++;
+        xSemaphoreGive(guard);
+        return true;
+    }
+
+    /**
+     * @brief 释放共享锁
+     */
+    void unlockShared() {
+        xSemaphoreTake(guard, portMAX_DELAY);
+        if (--readers == 0) {
+            xSemaphoreGive(resource);
+        }
+        xSemaphoreGive(guard);
+    }
+
+    /**
+     * @brief 加独占锁
+     * @param timeout 超时（tick）
+     * @return 是否成功
+     */
+    bool lock(TickType_t timeout = portMAX_DELAY) {
+        TickType_t start = xTaskGetTickCount();
+        if (xSemaphoreTake(turnstile, timeout) != pdTRUE) {
+            return false;
+        }
+        // 持有闸门直到解锁，期间新读者无法进入
+        if (xSemaphoreTake(resource, remaining(start, timeout)) != pdTRUE) {
+            xSemaphoreGive(turnstile);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 释放独占锁
+     */
+    void unlock() {
+        xSemaphoreGive(resource);
+        xSemaphoreGive(turnstile);
+    }
+
+   private:
+    static SemaphoreHandle_t createResource() {
+        SemaphoreHandle_t semaphore = xSemaphoreCreateBinary();
+        xSemaphoreGive(semaphore);
+        return semaphore;
+    }
+
+    /**
+     * @brief 计算剩余的等待时间
+     */
+    static TickType_t remaining(TickType_t start, TickType_t timeout) {
+        if (timeout == portMAX_DELAY) {
+            return portMAX_DELAY;
+        }
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        return elapsed >= timeout ? 0 : timeout - elapsed;
+    }
+
+    SemaphoreHandle_t turnstile = xSemaphoreCreateMutex();  // 写者闸门
+    SemaphoreHandle_t guard = xSemaphoreCreateMutex();      // 保护读者计数
+    SemaphoreHandle_t resource = createResource();          // 资源锁（二值信号量，允许跨任务释放）
+    uint32_t readers = 0;                                   // 当前读者数
+};
+
+/**
+ * @brief 锁等待时间直方图，记录时只做原子加法
+ */
+class LockWaitHistogram {
+   public:
+    static constexpr size_t BUCKET_COUNT = 6;
+    static constexpr uint32_t BUCKETS_US[BUCKET_COUNT] = {
+        10, 100, 1000, 10000, 100000, 1000000
+    };  // 桶上界（微秒），另有+Inf桶
+
+    /**
+     * @brief 统计快照
+     */
+    struct Snapshot {
+        uint32_t count;                       // 成功加锁次数
+        uint32_t timeouts;                    // 超时次数
+        uint64_t totalUs;                     // 累计等待时间
+        uint32_t maxUs;                       // 最长等待时间
+        uint32_t buckets[BUCKET_COUNT + 1];  // 各桶计数（非累计）
+    };
+
+    /**
+     * @brief 记录一次加锁
+     * @param waitUs 等待时间（微秒）
+     * @param acquired 是否成功加锁
+     */
+    void record(uint32_t waitUs, bool acquired) {
+        if (!acquired) {
+            timeouts.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        count.fetch_add(1, std::memory_order_relaxed);
+        totalUs.fetch_add(waitUs, std::memory_order_relaxed);
+        uint32_t max = maxUs.load(std::memory_order_relaxed);
+        while (waitUs > max && !maxUs.compare_exchange_weak(max, waitUs, std::memory_order_relaxed)) {
+        }
+
+        size_t bucket = 0;
+        while (bucket < BUCKET_COUNT && waitUs > BUCKETS_US[bucket]) {
+            bucket++;
+        }
+        buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 获取统计快照
+     */
+    Snapshot snapshot() const {
+        Snapshot result{};
+        result.count = count.load(std::memory_order_relaxed);
+        result.timeouts = timeouts.load(std::memory_order_relaxed);
+        result.totalUs = totalUs.load(std::memory_order_relaxed);
+        result.maxUs = maxUs.load(std::memory_order_relaxed);
+        for (size_t i = 0; i <= BUCKET_COUNT; i++) {
+            result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+   private:
+    std::atomic<uint32_t> count{0};
+    std::atomic<uint32_t> timeouts{0};
+    std::atomic<uint64_t> totalUs{0};
+    std::atomic<uint32_t> maxUs{0};
+    std::atomic<uint32_t> buckets[BUCKET_COUNT + 1]{};
+};
\ No newline at end of file
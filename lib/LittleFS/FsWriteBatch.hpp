@@ -0,0 +1,85 @@
+/**
+ * @file FsWriteBatch.hpp
+ * @brief 文件批量写入
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 一组文件写入和删除，由LittleFSController::commit()原子地提交
+ *
+ * 同一路径多次写入只保留最后一次，提交时每个文件只写一次。
+ * 提交本身比逐个写入多一次日志写入，批次的作用是原子性而不是减少flash写入。
+ */
+class FsWriteBatch {
+   public:
+    /**
+     * @brief 写入文件
+     * @param path 文件路径
+     * @param data 文件内容
+     * @param length 内容长度
+     */
+    void put(const char* path, const uint8_t* data, size_t length) {
+        Operation& op = find(path);
+        op.content.assign(reinterpret_cast<const char*>(data), length);
+        op.remove = false;
+    }
+
+    /**
+     * @brief 写入文本文件
+     */
+    void put(const char* path, const char* content) {
+        put(path, reinterpret_cast<const uint8_t*>(content), strlen(content));
+    }
+
+    /**
+     * @brief 删除文件（文件不存在时忽略）
+     */
+    void remove(const char* path) {
+        Operation& op = find(path);
+        op.content.clear();
+        op.content.shrink_to_fit();
+        op.remove = true;
+    }
+
+    /**
+     * @brief 操作数
+     */
+    size_t size() const {
+        return operations.size();
+    }
+
+    bool empty() const {
+        return operations.empty();
+    }
+
+    void clear() {
+        operations.clear();
+    }
+
+   private:
+    friend class LittleFSController;
+
+    struct Operation {
+        std::string path;     // 文件路径
+        std::string content;  // 文件内容
+        bool remove;          // 是否为删除
+    };
+
+    Operation& find(const char* path) {
+        for (Operation& op : operations) {
+            if (op.path == path) {
+                return op;
+            }
+        }
+        operations.push_back({path, {}, false});
+        return operations.back();
+    }
+
+    std::vector<Operation> operations;
+};
\ No newline at end of file
@@ -0,0 +1,468 @@
+/**
+ * @file KvStore.hpp
+ * @brief 基于LittleFS的键值配置存储
+ * @details 所有键值保存在一个追加写入的文件中，启动时一次读入并建立内存索引，读取不访问flash
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "LittleFSController.hpp"
+
+/**
+ * @brief 值类型
+ */
+enum class KvType : uint8_t {
+    NONE = 0,        // 不存在（文件中表示删除）
+    BOOL = 1,        // 布尔
+    INT = 2,         // 64位整数
+    FLOAT = 3,       // 双精度浮点
+    STRING = 4,      // 字符串
+    BLOB = 5,        // 二进制
+    STRING_LIST = 6  // 字符串列表
+};
+
+/**
+ * @brief 键值配置存储单例
+ *
+ * - 文件格式：4字节魔数，之后是连续的记录；记录头为 类型(1) 键长度(1) 值长度(2) CRC32(4)，随后是键和值
+ * - 写入只在文件末尾追加一条记录，值没有变化时不写入
+ * - 失效记录超过一半时，用LittleFSController::writeFile()原子地重写整个文件（压缩）
+ * - 启动时一次读取整个文件，遇到损坏或不完整的记录（复位时写了一半）即停止，并立即压缩去掉末尾
+ *
+ * @note 键最长255字节，值最长65535字节；适合配置等小数据，所有值常驻内存
+ */
+class KvStore {
+    static constexpr const char* TAG = "KvStore";
+
+   public:
+    static constexpr const char* DEFAULT_PATH = "/config.kv";
+    static constexpr uint32_t FILE_MAGIC = 0x3153564B;  // "KVS1"
+    static constexpr size_t COMPACT_MIN_SIZE = 4096;     // 文件小于该大小时不压缩
+
+    static KvStore& getInstance() {
+        static KvStore instance;
+        return instance;
+    }
+
+    /**
+     * @brief 加载存储文件，文件系统需已挂载
+     * @details 文件系统卸载后拒绝写入，重新挂载或格式化后自动重新加载
+     * @param path 文件路径
+     * @return 是否成功；文件存在但读取失败时返回false，此后的写入都会被拒绝
+     */
+    bool begin(const char* path = DEFAULT_PATH) {
+        auto& fs = LittleFSController::getInstance();
+        if (mountListenerId == 0) {
+            mountListenerId = fs.addMountListener([this](LittleFSController::MountEvent event) {
+                onMountEvent(event);
+            });
+        }
+
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+
+        filePath = path;
+        index.clear();
+        fileSize = 0;
+        liveSize = sizeof(FILE_MAGIC);
+        loaded = false;
+
+        // 读取失败时不能判断内容是否损坏，保持未加载状态，拒绝写入以免压缩时覆盖原文件
+        std::string content;
+        if (fs.exists(path) && !fs.tryReadFile(path, content, portMAX_DELAY)) {
+            ESP_LOGE(TAG, "Failed to read %s, store left unloaded", path);
+            xSemaphoreGive(mutex);
+            return false;
+        }
+
+        bool clean = load(content);
+        if (!clean || fileSize == 0) {
+            // 新文件、格式不符或末尾有损坏的记录，重写为只含有效记录的文件
+            if (!content.empty()) {
+                ESP_LOGW(TAG, "Discarding %u bytes of damaged data in %s", content.size() - fileSize, path);
+            }
+            compactLocked();
+        }
+
+        loaded = true;
+        ESP_LOGI(TAG, "Loaded %u keys from %s (%u of %u bytes live)", index.size(), path, liveSize, fileSize);
+        xSemaphoreGive(mutex);
+        return true;
+    }
+
+    /**
+     * @brief 键是否存在
+     */
+    bool contains(const char* key) {
+        return getType(key) != KvType::NONE;
+    }
+
+    /**
+     * @brief 获取值类型，不存在时为NONE
+     */
+    KvType getType(const char* key) {
+        KvType type = KvType::NONE;
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            auto it = index.find(key);
+            if (it != index.end()) {
+                type = it->second.type;
+            }
+            xSemaphoreGive(mutex);
+        }
+        return type;
+    }
+
+    bool setBool(const char* key, bool value) {
+        uint8_t byte = value ? 1 : 0;
+        return set(key, KvType::BOOL, &byte, sizeof(byte));
+    }
+
+    bool setInt(const char* key, int64_t value) {
+        return set(key, KvType::INT, &value, sizeof(value));
+    }
+
+    bool setFloat(const char* key, double value) {
+        return set(key, KvType::FLOAT, &value, sizeof(value));
+    }
+
+    bool setString(const char* key, const char* value) {
+        return set(key, KvType::STRING, value, strlen(value));
+    }
+
+    bool setBlob(const char* key, const void* data, size_t length) {
+        return set(key, KvType::BLOB, data, length);
+    }
+
+    /**
+     * @brief 保存字符串列表，元素中不能包含'\0'
+     */
+    bool setStrings(const char* key, const std::vector<std::string>& values) {
+        std::string encoded;
+        for (const std::string& value : values) {
+            encoded += value;
+            encoded += '\0';
+        }
+        return set(key, KvType::STRING_LIST, encoded.data(), encoded.size());
+    }
+
+    bool getBool(const char* key, bool defaultValue = false) {
+        std::string value;
+        return get(key, KvType::BOOL, value) && value.size() == 1 ? value[0] != 0 : defaultValue;
+    }
+
+    int64_t getInt(const char* key, int64_t defaultValue = 0) {
+        std::string value;
+        int64_t result = defaultValue;
+        if (get(key, KvType::INT, value) && value.size() == sizeof(result)) {
+            memcpy(&result, value.data(), sizeof(result));
+        }
+        return result;
+    }
+
+    double getFloat(const char* key, double defaultValue = 0) {
+        std::string value;
+        double result = defaultValue;
+        if (get(key, KvType::FLOAT, value) && value.size() == sizeof(result)) {
+            memcpy(&result, value.data(), sizeof(result));
+        }
+        return result;
+    }
+
+    std::string getString(const char* key, const char* defaultValue = "") {
+        std::string value;
+        return get(key, KvType::STRING, value) ? value : std::string(defaultValue);
+    }
+
+    /**
+     * @brief 读取二进制值
+     * @return 是否存在
+     */
+    bool getBlob(const char* key, std::string& value) {
+        return get(key, KvType::BLOB, value);
+    }
+
+    std::vector<std::string> getStrings(const char* key) {
+        std::vector<std::string> values;
+        std::string encoded;
+        if (get(key, KvType::STRING_LIST, encoded)) {
+            for (size_t start = 0; start < encoded.size();) {
+                size_t end = encoded.find('\0', start);
+                if (end == std::string::npos) end = encoded.size();
+                values.push_back(encoded.substr(start, end - start));
+                start = end + 1;
+            }
+        }
+        return values;
+    }
+
+    /**
+     * @brief 删除键
+     * @return 是否成功（键不存在也返回true）
+     */
+    bool remove(const char* key) {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        bool success = true;
+        auto it = index.find(key);
+        if (loaded && it != index.end()) {
+            size_t previousLiveSize = liveSize;
+            Value previous = std::move(it->second);
+            liveSize -= recordSize(it->first, previous.value);
+            index.erase(it);
+            success = appendLocked(key, KvType::NONE, nullptr, 0);
+            if (!success) {
+                index.emplace(key, std::move(previous));
+                liveSize = previousLiveSize;
+            }
+        }
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 立即压缩存储文件
+     * @return 是否成功
+     */
+    bool compact() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        bool success = loaded && compactLocked();
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 键的数量
+     */
+    size_t size() {
+        size_t count = 0;
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            count = index.size();
+            xSemaphoreGive(mutex);
+        }
+        return count;
+    }
+
+   private:
+    struct RecordHeader {
+        KvType type;           // 值类型，NONE表示删除
+        uint8_t keyLength;     // 键长度
+        uint16_t valueLength;  // 值长度
+        uint32_t crc;          // 头部（crc为0）、键和值的CRC32
+    };
+
+    static constexpr size_t HEADER_SIZE = sizeof(RecordHeader);
+    static_assert(HEADER_SIZE == 8, "Unexpected record header size");
+
+    /**
+     * @brief 文件系统挂载状态变化
+     * @details 卸载后文件可能被整体替换（如写入分区镜像），fileSize和索引都已失效，
+     *          继续追加会写到没有魔数的文件中；卸载期间只读内存索引，重新挂载后从文件重新加载
+     */
+    void onMountEvent(LittleFSController::MountEvent event) {
+        if (event == LittleFSController::MountEvent::UNMOUNTED) {
+            if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+                loaded = false;
+                xSemaphoreGive(mutex);
+            }
+        } else if (event == LittleFSController::MountEvent::MOUNTED) {
+            std::string path = filePath;
+            begin(path.c_str());
+        }
+    }
+
+    struct Value {
+        KvType type;        // 值类型
+        std::string value;  // 值
+    };
+
+    KvStore() = default;
+    KvStore(const KvStore&) = delete;
+    KvStore& operator=(const KvStore&) = delete;
+
+    bool set(const char* key, KvType type, const void* data, size_t length) {
+        size_t keyLength = strlen(key);
+        if (keyLength == 0 || keyLength > UINT8_MAX || length > UINT16_MAX) {
+            ESP_LOGE(TAG, "Invalid key or value size: %s", key);
+            return false;
+        }
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        if (!loaded) {
+            ESP_LOGE(TAG, "Store not loaded");
+            xSemaphoreGive(mutex);
+            return false;
+        }
+
+        std::string value(static_cast<const char*>(data), length);
+        size_t previousLiveSize = liveSize;
+        Value previous{KvType::NONE, std::string()};
+        auto it = index.find(key);
+        if (it != index.end()) {
+            if (it->second.type == type && it->second.value == value) {
+                xSemaphoreGive(mutex);
+                return true;
+            }
+            liveSize -= recordSize(it->first, it->second.value);
+            previous = std::move(it->second);
+        }
+        liveSize += recordSize(key, value);
+        index[key] = {type, std::move(value)};
+
+        // 压缩按索引重写文件，索引需先修改；写入失败时恢复，避免之后读到或持久化未保存的值
+        bool success = appendLocked(key, type, data, length);
+        if (!success) {
+            if (previous.type == KvType::NONE) {
+                index.erase(key);
+            } else {
+                index[key] = std::move(previous);
+            }
+            liveSize = previousLiveSize;
+        }
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    bool get(const char* key, KvType type, std::string& value) {
+        bool found = false;
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            auto it = index.find(key);
+            if (it != index.end()) {
+                if (it->second.type == type) {
+                    value = it->second.value;
+                    found = true;
+                } else {
+                    ESP_LOGW(TAG, "Type mismatch for %s", key);
+                }
+            }
+            xSemaphoreGive(mutex);
+        }
+        return found;
+    }
+
+    /**
+     * @brief 解析文件内容建立索引
+     * @return 是否完整解析（没有损坏的记录）
+     */
+    bool load(const std::string& content) {
+        uint32_t magic = 0;
+        if (content.size() < sizeof(magic)) {
+            return content.empty();
+        }
+        memcpy(&magic, content.data(), sizeof(magic));
+        if (magic != FILE_MAGIC) {
+            ESP_LOGE(TAG, "Unknown file format: %s", filePath.c_str());
+            return false;
+        }
+
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(content.data());
+        size_t offset = sizeof(magic);
+        while (offset + HEADER_SIZE <= content.size()) {
+            RecordHeader header;
+            memcpy(&header, data + offset, HEADER_SIZE);
+            size_t size = HEADER_SIZE + header.keyLength + header.valueLength;
+            if (header.type > KvType::STRING_LIST || header.keyLength == 0 || offset + size > content.size() ||
+                checksum(header, data + offset + HEADER_SIZE) != header.crc) {
+                break;
+            }
+
+            std::string key(content, offset + HEADER_SIZE, header.keyLength);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                liveSize -= recordSize(it->first, it->second.value);
+                index.erase(it);
+            }
+            if (header.type != KvType::NONE) {
+                Value value{header.type, content.substr(offset + HEADER_SIZE + header.keyLength, header.valueLength)};
+                liveSize += recordSize(key, value.value);
+                index.emplace(std::move(key), std::move(value));
+            }
+            offset += size;
+        }
+
+        fileSize = offset;
+        return offset == content.size();
+    }
+
+    /**
+     * @brief 追加一条记录，失效数据过多时改为压缩，调用者需持有锁
+     */
+    bool appendLocked(const char* key, KvType type, const void* data, size_t length) {
+        std::string record;
+        encode(record, key, strlen(key), type, data, length);
+
+        if (fileSize + record.size() >= COMPACT_MIN_SIZE && fileSize + record.size() > liveSize * 2) {
+            return compactLocked();
+        }
+
+        auto& fs = LittleFSController::getInstance();
+        if (!fs.appendFile(filePath.c_str(), reinterpret_cast<const uint8_t*>(record.data()), record.size())) {
+            // 追加失败时文件末尾可能不完整，重写整个文件
+            return compactLocked();
+        }
+        fileSize += record.size();
+        return true;
+    }
+
+    /**
+     * @brief 按索引重写整个文件，调用者需持有锁
+     */
+    bool compactLocked() {
+        std::string content;
+        content.reserve(liveSize);
+        content.append(reinterpret_cast<const char*>(&FILE_MAGIC), sizeof(FILE_MAGIC));
+        for (const auto& [key, value] : index) {
+            encode(content, key.data(), key.size(), value.type, value.value.data(), value.value.size());
+        }
+
+        auto& fs = LittleFSController::getInstance();
+        if (!fs.writeFile(filePath.c_str(), reinterpret_cast<const uint8_t*>(content.data()), content.size())) {
+            ESP_LOGE(TAG, "Failed to compact %s", filePath.c_str());
+            return false;
+        }
+        ESP_LOGD(TAG, "Compacted %s: %u -> %u bytes", filePath.c_str(), fileSize, content.size());
+        fileSize = content.size();
+        liveSize = content.size();
+        return true;
+    }
+
+    static void encode(std::string& out, const char* key, size_t keyLength, KvType type, const void* data, size_t length) {
+        RecordHeader header{type, static_cast<uint8_t>(keyLength), static_cast<uint16_t>(length), 0};
+        size_t start = out.size();
+        out.append(reinterpret_cast<const char*>(&header), HEADER_SIZE);
+        out.append(key, keyLength);
+        out.append(static_cast<const char*>(data), length);
+        header.crc = checksum(header, reinterpret_cast<const uint8_t*>(out.data() + start + HEADER_SIZE));
+        memcpy(&out[start], &header, HEADER_SIZE);
+    }
+
+    static uint32_t checksum(RecordHeader header, const uint8_t* body) {
+        header.crc = 0;
+        uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), HEADER_SIZE);
+        return esp_rom_crc32_le(crc, body, header.keyLength + header.valueLength);
+    }
+
+    static size_t recordSize(const std::string& key, const std::string& value) {
+        return HEADER_SIZE + key.size() + value.size();
+    }
+
+    std::string filePath;                               // 存储文件路径
+    std::unordered_map<std::string, Value> index;       // 内存索引
+    size_t fileSize = 0;                                // 文件中有效数据的大小
+    size_t liveSize = 0;                                // 压缩后的文件大小
+    bool loaded = false;                                // 是否已加载
+    uint32_t mountListenerId = 0;                       // 挂载状态变化回调ID
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 互斥锁
+};
\ No newline at end of file
@@ -0,0 +1,544 @@
+/**
+ * @file LittleFSBenchmark.hpp
+ * @brief LittleFS性能测试
+ * @details 在设备上测量LittleFSController各类操作的吞吐和延迟，结果输出到日志
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <RawLog.hpp>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "LittleFSController.hpp"
+#include "RingLog.hpp"
+
+/**
+ * @brief LittleFS性能测试
+ *
+ * run()对每种大小的文件比较三种读取方式：
+ * - chunked：原readFile()的实现，128字节栈缓冲区循环append，作为基准
+ * - string：readFile(path)，先获取大小再一次读取
+ * - buffer：readFile(path, buffer, capacity, length)，读入预先分配的缓冲区
+ *
+ * runSuite()测量顺序读写、随机读、小记录追加、RingLog与RawLog的日志追加、小文件创建删除、
+ * 大目录列举和多任务锁竞争，每项结果输出一行"BENCH {json}"日志，可用grep提取后与其他版本或挂载参数的结果比较。
+ * sweep()依次用几组挂载参数重新挂载文件系统并运行runSuite()，标签为参数组合。
+ *
+ * @note 会在文件系统中创建并删除临时文件，耗时数秒到数十秒，只应在调试时调用；
+ * 指定rawLogLabel时会向该分区写入测试记录（覆盖最旧的记录），不应指定保存实际数据的分区
+ */
+class LittleFSBenchmark {
+    static constexpr const char* TAG = "LittleFSBenchmark";
+
+   public:
+    static constexpr size_t FILE_SIZES[] = {128, 1024, 4096, 16 * 1024, 64 * 1024, 256 * 1024};
+    static constexpr size_t SUITE_SIZES[] = {1024, 16 * 1024, 64 * 1024, 256 * 1024};
+    static constexpr size_t RANDOM_READ_SIZES[] = {256, 4096};
+    static constexpr const char* SUITE_DIR = "/.benchmark";
+
+    /**
+     * @brief runSuite()的参数
+     */
+    struct SuiteConfig {
+        const char* label = "default";      // 结果标签，用于区分版本或挂载参数
+        uint8_t iterations = 5;             // 顺序读写的重复次数
+        uint16_t randomReads = 200;         // 随机读次数
+        uint16_t appendRecords = 200;       // 追加的64字节记录数
+        const char* rawLogLabel = nullptr;  // RawLog测试使用的分区，需显式指定，nullptr时跳过
+        uint16_t churnFiles = 50;           // 创建删除的小文件数
+        uint16_t directoryFiles = 200;      // 列目录测试的文件数
+        uint8_t readerTasks = 3;            // 锁竞争测试的读任务数
+        uint8_t writerTasks = 1;            // 锁竞争测试的写任务数
+        uint32_t contentionMs = 3000;       // 锁竞争测试时长
+    };
+
+    /**
+     * @brief 一项测试的统计
+     */
+    struct Metric {
+        const char* test;   // 测试名称
+        size_t size;        // 每次操作的字节数或文件数
+        uint32_t ops;       // 操作次数
+        uint64_t totalUs;   // 总耗时
+        uint32_t minUs;     // 最短耗时
+        uint32_t maxUs;     // 最长耗时
+        uint64_t bytes;     // 总字节数
+
+        void add(uint32_t us, size_t length = 0) {
+            ops++;
+            totalUs += us;
+            minUs = std::min(minUs, us);
+            maxUs = std::max(maxUs, us);
+            bytes += length;
+        }
+    };
+
+    /**
+     * @brief 单个文件大小的测试结果（平均耗时，微秒）
+     */
+    struct Result {
+        size_t fileSize;     // 文件大小
+        uint32_t chunkedUs;  // 128字节分块读取
+        uint32_t stringUs;   // 一次读取到std::string
+        uint32_t bufferUs;   // 一次读取到预分配缓冲区
+    };
+
+    /**
+     * @brief 运行测试
+     * @param iterations 每种方式的重复次数
+     * @param path 临时文件路径
+     * @return 各文件大小的结果
+     */
+    static std::vector<Result> run(uint8_t iterations = 5, const char* path = "/.bench") {
+        auto& fs = LittleFSController::getInstance();
+        std::vector<Result> results;
+
+        for (size_t fileSize : FILE_SIZES) {
+            if (!fs.writeFile(path, std::string(fileSize, 'x').c_str())) {
+                ESP_LOGE(TAG, "Failed to create %u byte test file", fileSize);
+                break;
+            }
+
+            // 缓冲区优先放在PSRAM中，与大文件读取的实际场景一致
+            auto* buffer = static_cast<uint8_t*>(heap_caps_malloc(fileSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT));
+            if (!buffer) {
+                buffer = static_cast<uint8_t*>(heap_caps_malloc(fileSize, MALLOC_CAP_8BIT));
+            }
+            if (!buffer) {
+                ESP_LOGE(TAG, "Failed to allocate %u byte buffer", fileSize);
+                break;
+            }
+
+            Result result{fileSize, 0, 0, 0};
+            size_t length = 0;
+            result.chunkedUs = measure(iterations, [&]() { readChunked(path); });
+            result.stringUs = measure(iterations, [&]() { fs.readFile(path); });
+            result.bufferUs = measure(iterations, [&]() { fs.readFile(path, buffer, fileSize, length); });
+            heap_caps_free(buffer);
+
+            ESP_LOGI(
+                TAG,
+                "%6u bytes: chunked %7u us, string %7u us, buffer %7u us (%.1fx)",
+                fileSize,
+                result.chunkedUs,
+                result.stringUs,
+                result.bufferUs,
+                result.stringUs ? static_cast<float>(result.chunkedUs) / result.stringUs : 0
+            );
+            results.push_back(result);
+        }
+
+        fs.removeFile(path);
+        return results;
+    }
+
+    /**
+     * @brief 使用默认参数运行完整测试
+     */
+    static std::vector<Metric> runSuite() {
+        return runSuite(SuiteConfig());
+    }
+
+    /**
+     * @brief 运行完整测试
+     * @param config 测试参数
+     * @return 各项结果（同时以"BENCH {json}"格式输出到日志）
+     */
+    static std::vector<Metric> runSuite(const SuiteConfig& config) {
+        auto& fs = LittleFSController::getInstance();
+        std::vector<Metric> metrics;
+        fs.mkdir(SUITE_DIR);
+
+        std::string data(SUITE_SIZES[std::size(SUITE_SIZES) - 1], '\0');
+        for (size_t i = 0; i < data.size(); i++) {
+            data[i] = static_cast<char>(i * 31 + (i >> 8));
+        }
+        std::string path = std::string(SUITE_DIR) + "/seq";
+
+        // 顺序写入（原子替换）和分块读取
+        for (size_t size : SUITE_SIZES) {
+            Metric write = metric("seq_write", size);
+            Metric read = metric("seq_read", size);
+            for (uint8_t i = 0; i < config.iterations; i++) {
+                uint32_t start = micros();
+                bool success = fs.writeFile(path.c_str(), reinterpret_cast<const uint8_t*>(data.data()), size);
+                uint32_t elapsed = micros() - start;
+                if (!success) {
+                    ESP_LOGE(TAG, "Sequential write failed at %u bytes", size);
+                    break;
+                }
+                write.add(elapsed, size);
+
+                start = micros();
+                size_t total = 0;
+                fs.readChunks(path.c_str(), [&](const uint8_t*, size_t length, size_t) {
+                    total += length;
+                    return true;
+                });
+                read.add(micros() - start, total);
+            }
+            report(config, write, metrics);
+            report(config, read, metrics);
+        }
+
+        // 随机读：在最大的文件中随机定位
+        if (auto reader = fs.openReader(path.c_str())) {
+            size_t fileSize = reader.size();
+            std::vector<uint8_t> buffer(RANDOM_READ_SIZES[std::size(RANDOM_READ_SIZES) - 1]);
+            uint32_t seed = 12345;
+            for (size_t size : RANDOM_READ_SIZES) {
+                Metric read = metric("rand_read", size);
+                for (uint16_t i = 0; i < config.randomReads && fileSize > size; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    size_t offset = (seed >> 8) % (fileSize - size);
+                    uint32_t start = micros();
+                    size_t length = reader.seek(offset) ? reader.read(buffer.data(), size) : 0;
+                    read.add(micros() - start, length);
+                }
+                report(config, read, metrics);
+            }
+        }
+        fs.removeFile(path.c_str());
+
+        // 小记录追加（日志类写入）
+        path = std::string(SUITE_DIR) + "/append";
+        Metric append = metric("append", 64);
+        for (uint16_t i = 0; i < config.appendRecords; i++) {
+            uint32_t start = micros();
+            if (!fs.appendFile(path.c_str(), reinterpret_cast<const uint8_t*>(data.data()), 64)) {
+                break;
+            }
+            append.add(micros() - start, 64);
+        }
+        report(config, append, metrics);
+        fs.removeFile(path.c_str());
+
+        // 日志追加：LittleFS上的RingLog与裸分区上的RawLog
+        path = std::string(SUITE_DIR) + "/ring";
+        {
+            RingLog log(path.c_str());
+            if (log.begin()) {
+                runLogAppend(config, log, "ring_log_append", "ring_log_burst", data, metrics);
+            }
+        }
+        for (const std::string& segment : fs.listDir(path.c_str())) {
+            fs.removeFile((path + "/" + segment).c_str());
+        }
+        fs.rmdir(path.c_str());
+        if (config.rawLogLabel) {
+            RawLog log(config.rawLogLabel);
+            if (log.begin()) {
+                runLogAppend(config, log, "raw_log_append", "raw_log_burst", data, metrics);
+            } else {
+                ESP_LOGW(TAG, "Skipping RawLog test, partition %s unavailable or in use", config.rawLogLabel);
+            }
+        }
+
+        // 小文件创建删除
+        Metric create = metric("churn_create", 64);
+        Metric remove = metric("churn_remove", 64);
+        char name[48];
+        for (uint16_t i = 0; i < config.churnFiles; i++) {
+            snprintf(name, sizeof(name), "%s/c%04u", SUITE_DIR, i);
+            uint32_t start = micros();
+            if (fs.writeFile(name, reinterpret_cast<const uint8_t*>(data.data()), 64)) {
+                create.add(micros() - start, 64);
+            }
+        }
+        for (uint16_t i = 0; i < config.churnFiles; i++) {
+            snprintf(name, sizeof(name), "%s/c%04u", SUITE_DIR, i);
+            uint32_t start = micros();
+            if (fs.removeFile(name)) {
+                remove.add(micros() - start, 64);
+            }
+        }
+        report(config, create, metrics);
+        report(config, remove, metrics);
+
+        // 大目录列举
+        for (uint16_t i = 0; i < config.directoryFiles; i++) {
+            snprintf(name, sizeof(name), "%s/d%04u", SUITE_DIR, i);
+            fs.writeFile(name, reinterpret_cast<const uint8_t*>(data.data()), 16);
+        }
+        Metric list = metric("list_dir", config.directoryFiles);
+        Metric walk = metric("walk_dir", config.directoryFiles);
+        Metric cached = metric("list_dir_cached", config.directoryFiles);
+        for (uint8_t i = 0; i < config.iterations; i++) {
+            uint32_t start = micros();
+            fs.listDir(SUITE_DIR);
+            list.add(micros() - start);
+
+            size_t total = 0;
+            start = micros();
+            fs.walkDir(SUITE_DIR, [&](const LittleFSController::DirEntry& entry) {
+                total += entry.size;
+                return true;
+            });
+            walk.add(micros() - start, total);
+
+            start = micros();
+            fs.listDirCached(SUITE_DIR);
+            cached.add(micros() - start);
+        }
+        report(config, list, metrics);
+        report(config, walk, metrics);
+        report(config, cached, metrics);
+        for (uint16_t i = 0; i < config.directoryFiles; i++) {
+            snprintf(name, sizeof(name), "%s/d%04u", SUITE_DIR, i);
+            fs.removeFile(name);
+        }
+
+        runContention(config, metrics);
+        fs.rmdir(SUITE_DIR);
+        return metrics;
+    }
+
+    /**
+     * @brief 使用默认测试参数比较各组挂载参数
+     */
+    static bool sweep(const std::vector<LittleFSController::Config>& configs) {
+        return sweep(configs, SuiteConfig());
+    }
+
+    /**
+     * @brief 依次使用各组挂载参数重新挂载并运行完整测试，结束后恢复原参数
+     * @param configs 挂载参数
+     * @param suite 测试参数，label被替换为参数组合
+     * @return 是否全部挂载成功
+     * @note 重新挂载期间其他任务的文件操作会失败，只应在启动阶段调用
+     */
+    static bool sweep(const std::vector<LittleFSController::Config>& configs, SuiteConfig suite) {
+        auto& fs = LittleFSController::getInstance();
+        LittleFSController::Config original = fs.getConfig();
+        bool success = true;
+
+        for (const LittleFSController::Config& config : configs) {
+            char label[48];
+            snprintf(
+                label,
+                sizeof(label),
+                "files%u_ra%u_%s",
+                config.maxOpenFiles,
+                config.readAhead,
+                config.psramBuffers ? "psram" : "internal"
+            );
+            fs.setConfig(config);
+            if (!fs.remount()) {
+                ESP_LOGE(TAG, "Failed to remount with %s", label);
+                success = false;
+                continue;
+            }
+            suite.label = label;
+            runSuite(suite);
+        }
+
+        fs.setConfig(original);
+        return fs.remount() && success;
+    }
+
+   private:
+    static constexpr uint8_t CONTENTION_FILES = 4;     // 锁竞争测试的文件数
+    static constexpr size_t CONTENTION_SIZE = 4096;    // 锁竞争测试的文件大小
+
+    /**
+     * @brief 锁竞争测试的任务参数
+     */
+    struct Worker {
+        bool writer;                   // 是否为写任务
+        uint32_t durationMs;           // 运行时长
+        Metric metric;                 // 统计结果
+        std::atomic<uint8_t>* active;  // 未结束的任务数
+    };
+
+    /**
+     * @brief 多个任务同时读写同一组文件，测量每次操作的耗时和锁等待
+     */
+    static void runContention(const SuiteConfig& config, std::vector<Metric>& metrics) {
+        auto& fs = LittleFSController::getInstance();
+        std::string content(CONTENTION_SIZE, 'c');
+        char name[48];
+        for (uint8_t i = 0; i < CONTENTION_FILES; i++) {
+            snprintf(name, sizeof(name), "%s/lock%u", SUITE_DIR, i);
+            fs.writeFile(name, content.c_str());
+        }
+
+        LittleFSController::LockStats before = fs.getLockStats();
+        std::atomic<uint8_t> active{0};
+        std::vector<Worker> workers;
+        for (uint8_t i = 0; i < config.readerTasks + config.writerTasks; i++) {
+            bool writer = i >= config.readerTasks;
+            workers.push_back({writer, config.contentionMs, metric(writer ? "contended_write" : "contended_read", CONTENTION_SIZE), &active});
+        }
+
+        for (Worker& worker : workers) {
+            active++;
+            BaseType_t xReturned = xTaskCreate(
+                [](void* param) {
+                    auto& worker = *static_cast<Worker*>(param);
+                    auto& fs = LittleFSController::getInstance();
+                    std::string buffer(CONTENTION_SIZE, worker.writer ? 'w' : 'r');
+                    char name[48];
+                    uint32_t begin = millis();
+                    for (uint32_t i = 0; millis() - begin < worker.durationMs; i++) {
+                        snprintf(name, sizeof(name), "%s/lock%u", SUITE_DIR, i % CONTENTION_FILES);
+                        uint32_t start = micros();
+                        bool success = worker.writer ? fs.writeFile(name, buffer.c_str()) : fs.tryReadFile(name, buffer, portMAX_DELAY);
+                        if (success) {
+                            worker.metric.add(micros() - start, CONTENTION_SIZE);
+                        }
+                    }
+                    (*worker.active)--;
+                    vTaskDelete(nullptr);
+                },
+                worker.writer ? "bench_write" : "bench_read",
+                4096,
+                &worker,
+                1,
+                nullptr
+            );
+            if (xReturned != pdPASS) {
+                ESP_LOGE(TAG, "Failed to create benchmark task");
+                active--;
+            }
+        }
+        while (active > 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+
+        Metric read = metric("contended_read", CONTENTION_SIZE);
+        Metric write = metric("contended_write", CONTENTION_SIZE);
+        for (Worker& worker : workers) {
+            Metric& total = worker.writer ? write : read;
+            total.ops += worker.metric.ops;
+            total.totalUs += worker.metric.totalUs;
+            total.minUs = std::min(total.minUs, worker.metric.minUs);
+            total.maxUs = std::max(total.maxUs, worker.metric.maxUs);
+            total.bytes += worker.metric.bytes;
+        }
+        report(config, read, metrics);
+        report(config, write, metrics);
+
+        // 锁等待：次数和总时间为测试期间的增量，最长时间为累计值
+        LittleFSController::LockStats after = fs.getLockStats();
+        Metric sharedWait = metric("lock_wait_shared", 0);
+        sharedWait.ops = after.shared.count - before.shared.count;
+        sharedWait.totalUs = after.shared.totalUs - before.shared.totalUs;
+        sharedWait.minUs = 0;
+        sharedWait.maxUs = after.shared.maxUs;
+        Metric exclusiveWait = metric("lock_wait_exclusive", 0);
+        exclusiveWait.ops = after.exclusive.count - before.exclusive.count;
+        exclusiveWait.totalUs = after.exclusive.totalUs - before.exclusive.totalUs;
+        exclusiveWait.minUs = 0;
+        exclusiveWait.maxUs = after.exclusive.maxUs;
+        report(config, sharedWait, metrics);
+        report(config, exclusiveWait, metrics);
+
+        for (uint8_t i = 0; i < CONTENTION_FILES; i++) {
+            snprintf(name, sizeof(name), "%s/lock%u", SUITE_DIR, i);
+            fs.removeFile(name);
+        }
+    }
+
+    /**
+     * @brief 日志追加测试
+     * @details append为每条64字节记录追加后立即刷新的耗时；
+     * burst为连续追加appendRecords条记录后刷新一次的总耗时，反映缓冲写入的吞吐
+     */
+    template <typename Log>
+    static void runLogAppend(
+        const SuiteConfig& config,
+        Log& log,
+        const char* appendName,
+        const char* burstName,
+        const std::string& data,
+        std::vector<Metric>& metrics
+    ) {
+        const auto* record = reinterpret_cast<const uint8_t*>(data.data());
+        Metric append = metric(appendName, 64);
+        for (uint16_t i = 0; i < config.appendRecords; i++) {
+            uint32_t start = micros();
+            if (log.append(record, 64) == 0 || !log.flush()) {
+                break;
+            }
+            append.add(micros() - start, 64);
+        }
+        report(config, append, metrics);
+
+        Metric burst = metric(burstName, config.appendRecords * 64);
+        bool success = true;
+        uint32_t start = micros();
+        for (uint16_t i = 0; i < config.appendRecords && success; i++) {
+            success = log.append(record, 64) != 0;
+        }
+        if (success && log.flush()) {
+            burst.add(micros() - start, config.appendRecords * 64);
+        }
+        report(config, burst, metrics);
+    }
+
+    static Metric metric(const char* test, size_t size) {
+        return {test, size, 0, 0, UINT32_MAX, 0, 0};
+    }
+
+    /**
+     * @brief 输出一行JSON结果并保存
+     */
+    static void report(const SuiteConfig& config, Metric metric, std::vector<Metric>& metrics) {
+        if (metric.ops == 0) {
+            metric.minUs = 0;
+        }
+        uint32_t avgUs = metric.ops ? metric.totalUs / metric.ops : 0;
+        uint32_t kibPerSecond = metric.totalUs ? metric.bytes * 1000000 / 1024 / metric.totalUs : 0;
+        ESP_LOGI(
+            TAG,
+            "BENCH {\"label\":\"%s\",\"test\":\"%s\",\"size\":%u,\"ops\":%u,\"avg_us\":%u,\"min_us\":%u,"
+            "\"max_us\":%u,\"kib_s\":%u}",
+            config.label,
+            metric.test,
+            metric.size,
+            metric.ops,
+            avgUs,
+            metric.minUs,
+            metric.maxUs,
+            kibPerSecond
+        );
+        metrics.push_back(metric);
+    }
+
+    template <typename Fn>
+    static uint32_t measure(uint8_t iterations, Fn&& fn) {
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < iterations; i++) {
+            uint32_t start = micros();
+            fn();
+            total += micros() - start;
+        }
+        return iterations ? total / iterations : 0;
+    }
+
+    /**
+     * @brief 原readFile()的实现，作为对比基准
+     */
+    static std::string readChunked(const char* path) {
+        std::string content;
+        File file = LittleFS.open(path, "r");
+        if (!file) {
+            return content;
+        }
+
+        char buf[128];
+        while (size_t bytesRead = file.read(reinterpret_cast<uint8_t*>(buf), sizeof(buf))) {
+            content.append(buf, bytesRead);
+        }
+        file.close();
+        return content;
+    }
+};
\ No newline at end of file
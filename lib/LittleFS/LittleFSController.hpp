@@ -5,18 +5,215 @@
 #pragma once
 
 #include <LittleFS.h>
+#include <dirent.h>
+#include <esp_heap_caps.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
+#include "AssetManifest.hpp"
+#include "FsRwLock.hpp"
+#include "FsWriteBatch.hpp"
+#include "MimeTypes.hpp"
 
 /**
  * @brief LittleFS文件系统控制器单例类
+ *
+ * 加锁策略：
+ * - 文件系统锁：普通读写操作持有共享锁，挂载、卸载、格式化持有独占锁
+ * - 路径锁：按路径哈希分成若干组，读文件持有共享锁，写入和删除持有独占锁，
+ *   不同文件的读写互不阻塞，同一文件的写入与读取互斥
+ *
+ * 写入：writeFile()先写临时文件再重命名覆盖，复位不会留下写了一半的文件；
+ * commit()把一组写入和删除作为一个整体提交，通过日志文件保证复位后全部生效或全部不生效。
+ *
+ * 目录：walkDir()用回调逐项返回名称、类型和可选的大小、修改时间，不为每项分配内存，可递归；
+ * 每次修改都会递增所在目录及其上级目录的代数，listDirCached()在代数不变时直接返回缓存的结果。
+ *
+ * 资源清单：挂载时遍历一次MANIFEST_ROOT建立内存清单，之后该目录下的exists()、getFileSize()和
+ * getAssetInfo()不访问flash，通过本类的写入、追加、删除会同步更新清单。
+ *
+ * 挂载参数通过Config传入init()。littlefs的读写缓存、预读(lookahead)和块擦写周期是框架编译期配置，
+ * 运行时只能调整最大打开文件数和本类的流式读取缓冲区，init()会把编译期配置打印到日志，
+ * 可配合LittleFSBenchmark::sweep()比较不同参数的效果。
+ *
+ * 读写文件、列目录和删除有带超时的try*版本（timeoutMs为portMAX_DELAY时一直等待），
+ * 锁等待时间记录在直方图中，可通过getLockStats()获取。
  */
 class LittleFSController {
     static constexpr const char* TAG = "LittleFSController";
 
    public:
+    static constexpr const char* PARTITION_LABEL = "spiffs";  // 文件系统分区名称
+    static constexpr const char* BASE_PATH = "/littlefs";     // VFS挂载点
+    static constexpr size_t MAX_PATH_LENGTH = 256;            // walkDir()支持的最长路径
+    static constexpr size_t PATH_LOCK_COUNT = 8;              // 路径锁分组数
+    static constexpr const char* TEMP_SUFFIX = ".~lfs";       // 临时文件后缀，保留给本类，挂载时会删除
+    static constexpr const char* JOURNAL_PATH = "/.journal";  // 批量提交日志
+    static constexpr const char* MANIFEST_ROOT = "/wwwroot";  // 资源清单目录
+    static constexpr uint8_t MANIFEST_DEPTH = 8;              // 资源清单的最大目录深度
+
+    /**
+     * @brief 挂载参数
+     */
+    struct Config {
+        bool formatOnFail = true;  // 首次挂载失败时格式化（remount()始终不格式化）
+        uint8_t maxOpenFiles = 10;  // 同时打开的文件数上限，每个打开的文件占用一份littlefs文件缓存
+        size_t readAhead = 4;       // readChunks()每次加锁预读的块数，缓冲区大小为块大小×预读块数
+        bool psramBuffers = true;   // 流式读取缓冲区优先放在PSRAM中，内部RAM留给littlefs缓存
+    };
+
+    // 分块读取回调，offset为该块在文件中的位置，返回false时停止读取
+    using ChunkHandler = std::function<bool(const uint8_t* data, size_t length, size_t offset)>;
+
+    /**
+     * @brief walkDir()返回的目录项，字符串只在回调期间有效
+     */
+    struct DirEntry {
+        const char* name;  // 名称
+        const char* path;  // 完整路径（以'/'开头）
+        size_t size;       // 文件大小，目录或未获取时为0
+        bool isDirectory;  // 是否为目录
+        time_t mtime;      // 修改时间，未获取时为0
+        uint8_t depth;     // 相对起始目录的深度，直接子项为0
+    };
+
+    // 目录遍历回调，返回false时停止遍历
+    using DirVisitor = std::function<bool(const DirEntry& entry)>;
+
+    /**
+     * @brief listDirCached()返回的目录项
+     */
+    struct FileInfo {
+        std::string path;  // 完整路径
+        size_t size;       // 文件大小，目录为0
+        bool isDirectory;  // 是否为目录
+        time_t mtime;      // 修改时间
+    };
+
+    using FileList = std::shared_ptr<const std::vector<FileInfo>>;
+
+    /**
+     * @brief 挂载状态变化
+     */
+    enum class MountEvent {
+        UNMOUNTING,  // 即将卸载或格式化，可在回调中写回缓冲的数据
+        UNMOUNTED,   // 已卸载（含重新挂载失败），此时不能访问文件
+        MOUNTED      // 已重新挂载或格式化，文件内容可能已整体改变，需重新加载
+    };
+
+    // 挂载状态变化回调，在文件系统锁外调用；回调中可以读写文件，但不能注册、注销回调或卸载、重新挂载
+    using MountListener = std::function<void(MountEvent event)>;
+
+    /**
+     * @brief 锁等待统计
+     */
+    struct LockStats {
+        LockWaitHistogram::Snapshot shared;     // 共享访问（读取、列目录）
+        LockWaitHistogram::Snapshot exclusive;  // 独占访问（写入、删除、挂载）
+    };
+
+    /**
+     * @brief 流式读取器，每次read()只在读取期间持有文件系统锁
+     * @note 读取器持有打开的文件，应尽快读完或关闭；不能跨任务同时使用同一个读取器。
+     *       unmount()、remount()、format()会等待所有读取器关闭
+     */
+    class Reader {
+       public:
+        Reader() = default;
+
+        Reader(Reader&& other) noexcept : file(other.file), owner(other.owner), pathLock(other.pathLock) {
+            other.file = File();
+        }
+
+        Reader& operator=(Reader&& other) noexcept {
+            if (this != &other) {
+                close();
+                file = other.file;
+                owner = other.owner;
+                pathLock = other.pathLock;
+                other.file = File();
+            }
+            return *this;
+        }
+
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        ~Reader() {
+            close();
+        }
+
+        /**
+         * @brief 文件是否已打开
+         */
+        explicit operator bool() const {
+            return static_cast<bool>(file);
+        }
+
+        /**
+         * @brief 文件大小
+         */
+        size_t size() {
+            return file ? file.size() : 0;
+        }
+
+        /**
+         * @brief 读取下一段数据
+         * @param buffer 缓冲区
+         * @param length 最多读取的字节数
+         * @return 实际读取的字节数，0表示已到文件末尾或出错
+         */
+        size_t read(uint8_t* buffer, size_t length) {
+            if (!file) {
+                return 0;
+            }
+            Lock lock(*owner, pathLock, Access::READ, portMAX_DELAY);
+            return lock ? file.read(buffer, length) : 0;
+        }
+
+        /**
+         * @brief 移动读取位置
+         * @param offset 相对文件开头的偏移
+         * @return 是否成功
+         */
+        bool seek(size_t offset) {
+            if (!file) {
+                return false;
+            }
+            Lock lock(*owner, pathLock, Access::READ, portMAX_DELAY);
+            return lock && file.seek(offset);
+        }
+
+        /**
+         * @brief 关闭文件
+         */
+        void close() {
+            if (file) {
+                Lock lock(*owner, pathLock, Access::READ, portMAX_DELAY);
+                file.close();
+                file = File();
+                owner->openReaders--;
+            }
+        }
+
+       private:
+        friend class LittleFSController;
+
+        Reader(File file, LittleFSController* owner, size_t pathLock)
+            : file(file), owner(owner), pathLock(pathLock) {}
+
+        File file;
+        LittleFSController* owner = nullptr;
+        size_t pathLock = 0;
+    };
+
     /**
      * @brief 获取实例
      * @return 单例引用
@@ -31,25 +228,34 @@ class LittleFSController {
      * @return 初始化是否成功
      */
     bool init() {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            if (isInitialized) {
-                ESP_LOGW(TAG, "LittleFSController already initialized");
-                xSemaphoreGive(mutex);
-                return true;
-            }
-
-            if (!LittleFS.begin(true)) {
-                ESP_LOGE(TAG, "Failed to mount LittleFS");
-                xSemaphoreGive(mutex);
-                return false;
-            }
+        return init(Config());
+    }
 
-            isInitialized = true;
-            ESP_LOGI(TAG, "LittleFS mounted successfully");
-            xSemaphoreGive(mutex);
+    /**
+     * @brief 使用指定参数初始化文件系统
+     * @param mountConfig 挂载参数
+     * @return 初始化是否成功
+     */
+    bool init(const Config& mountConfig) {
+        Lock lock(*this, NO_PATH, Access::EXCLUSIVE, portMAX_DELAY);
+        if (isInitialized) {
+            ESP_LOGW(TAG, "LittleFSController already initialized");
             return true;
         }
-        return false;
+
+        setConfigLocked(mountConfig);
+        if (!LittleFS.begin(config.formatOnFail, BASE_PATH, config.maxOpenFiles, PARTITION_LABEL)) {
+            ESP_LOGE(TAG, "Failed to mount LittleFS");
+            return false;
+        }
+
+        isInitialized = true;
+        ESP_LOGI(TAG, "LittleFS mounted successfully");
+        logMountOptions();
+        recoverJournal();
+        buildManifest();
+        epoch++;
+        return true;
     }
 
     /**
@@ -58,70 +264,295 @@ class LittleFSController {
      * @return 文件是否存在
      */
     bool exists(const char* path) {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            bool exists = LittleFS.exists(path);
-            xSemaphoreGive(mutex);
-            return exists;
+        AssetManifest::Info info;
+        if (manifest.isReady() && manifest.covers(path)) {
+            return manifest.lookup(path, info);
         }
-        return false;
+        Lock lock(*this, NO_PATH, Access::READ, portMAX_DELAY);
+        return lock && LittleFS.exists(path);
+    }
+
+    /**
+     * @brief 从资源清单查询资源目录中的文件，不访问flash
+     * @param path 文件路径，需在MANIFEST_ROOT下
+     * @param info 输出大小、修改时间、MIME类型、压缩版本等信息
+     * @return 是否存在；路径不在资源目录中或清单未建立时返回false
+     */
+    bool getAssetInfo(const char* path, AssetManifest::Info& info) {
+        return manifest.isReady() && manifest.covers(path) && manifest.lookup(path, info);
     }
 
     /**
      * @brief 读取文件内容
+     * @details 先获取文件大小，一次分配、一次读取；大于4KB的分配由malloc放在PSRAM中
      * @param path 文件路径
      * @return 文件内容的字符串
      */
     std::string readFile(const char* path) {
         std::string content;
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            File file = LittleFS.open(path, "r");
-            if (!file) {
-                ESP_LOGE(TAG, "Failed to open file for reading: %s", path);
-                xSemaphoreGive(mutex);
-                return content;
-            }
+        tryReadFile(path, content, portMAX_DELAY);
+        return content;
+    }
 
-            // 分配缓冲区
-            const size_t bufSize = 128;
-            char buf[bufSize];
+    /**
+     * @brief 在超时内读取文件内容
+     * @param path 文件路径
+     * @param content 输出文件内容
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 是否读取成功，超时返回false
+     */
+    bool tryReadFile(const char* path, std::string& content, uint32_t timeoutMs) {
+        content.clear();
+        Lock lock(*this, pathLockOf(path), Access::READ, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout reading %s", path);
+            return false;
+        }
 
-            // 批量读取
-            while (size_t bytesRead = file.read((uint8_t*)buf, bufSize)) {
-                content.append(buf, bytesRead);
-            }
+        File file = LittleFS.open(path, "r");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open file for reading: %s", path);
+            return false;
+        }
+
+        content.resize(file.size());
+        size_t bytesRead = file.read(reinterpret_cast<uint8_t*>(content.data()), content.size());
+        file.close();
+        if (bytesRead != content.size()) {
+            ESP_LOGW(TAG, "Short read: %s, %u of %u bytes", path, bytesRead, content.size());
+            content.resize(bytesRead);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读取文件内容到调用者提供的缓冲区，不分配内存
+     * @param path 文件路径
+     * @param buffer 缓冲区
+     * @param capacity 缓冲区大小
+     * @param length 输出读取的字节数；缓冲区不足时为文件大小
+     * @return 是否读取了完整文件
+     */
+    bool readFile(const char* path, uint8_t* buffer, size_t capacity, size_t& length) {
+        return tryReadFile(path, buffer, capacity, length, portMAX_DELAY);
+    }
 
+    /**
+     * @brief 在超时内读取文件内容到调用者提供的缓冲区
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 是否读取了完整文件，超时返回false且length为0
+     */
+    bool tryReadFile(const char* path, uint8_t* buffer, size_t capacity, size_t& length, uint32_t timeoutMs) {
+        length = 0;
+        Lock lock(*this, pathLockOf(path), Access::READ, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout reading %s", path);
+            return false;
+        }
+
+        File file = LittleFS.open(path, "r");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open file for reading: %s", path);
+            return false;
+        }
+
+        size_t size = file.size();
+        if (size > capacity) {
+            ESP_LOGE(TAG, "Buffer too small for %s: %u < %u bytes", path, capacity, size);
             file.close();
-            xSemaphoreGive(mutex);
+            length = size;
+            return false;
         }
-        return content;
+
+        length = file.read(buffer, size);
+        file.close();
+        return length == size;
+    }
+
+    /**
+     * @brief 打开文件用于流式读取
+     * @param path 文件路径
+     * @return 读取器，打开失败时为空（bool值为false）
+     */
+    Reader openReader(const char* path) {
+        size_t pathLock = pathLockOf(path);
+        File file;
+        {
+            Lock lock(*this, pathLock, Access::READ, portMAX_DELAY);
+            if (!lock || draining > 0) {
+                ESP_LOGW(TAG, "Filesystem is unmounting, refusing to open %s", path);
+                return Reader();
+            }
+            file = LittleFS.open(path, "r");
+            if (file && !file.isDirectory()) {
+                // 在锁内计数，持有独占锁的卸载方能看到所有已打开的读取器
+                openReaders++;
+                return Reader(file, this, pathLock);
+            }
+        }
+        ESP_LOGE(TAG, "Failed to open file for reading: %s", path);
+        return Reader();
+    }
+
+    /**
+     * @brief 分块流式读取文件，内存占用与文件大小无关
+     * @details 每次加锁读取 blockSize * readAhead 字节，然后在锁外逐块调用回调，
+     *          回调处理期间其他任务可以访问文件系统
+     * @param path 文件路径
+     * @param handler 分块回调
+     * @param blockSize 每次回调的块大小
+     * @param readAhead 每次加锁预读的块数，0表示使用Config::readAhead
+     * @return 是否读完整个文件（回调返回false时为false）
+     */
+    bool readChunks(const char* path, const ChunkHandler& handler, size_t blockSize = 4096, size_t readAhead = 0) {
+        Reader reader = openReader(path);
+        if (readAhead == 0) {
+            readAhead = config.readAhead;
+        }
+        if (!reader || blockSize == 0 || readAhead == 0) {
+            return false;
+        }
+
+        size_t size = reader.size();
+        size_t capacity = std::min(blockSize * readAhead, std::max<size_t>(size, 1));
+        BufferPtr buffer(allocateBuffer(capacity));
+        if (!buffer) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte read buffer", capacity);
+            return false;
+        }
+
+        size_t offset = 0;
+        while (offset < size) {
+            size_t bytesRead = reader.read(buffer.get(), capacity);
+            if (bytesRead == 0) {
+                ESP_LOGE(TAG, "Read failed: %s at %u", path, offset);
+                return false;
+            }
+            for (size_t pos = 0; pos < bytesRead; pos += blockSize) {
+                size_t n = std::min(blockSize, bytesRead - pos);
+                if (!handler(buffer.get() + pos, n, offset + pos)) {
+                    return false;
+                }
+            }
+            offset += bytesRead;
+        }
+        return true;
     }
 
     /**
      * @brief 写入文件内容
+     * @details 先写入临时文件再重命名覆盖原文件，写入过程中复位原文件保持不变
      * @param path 文件路径
      * @param content 要写入的内容
      * @return 写入是否成功
      */
     bool writeFile(const char* path, const char* content) {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            File file = LittleFS.open(path, "w");
-            if (!file) {
-                ESP_LOGE(TAG, "Failed to open file for writing: %s", path);
-                xSemaphoreGive(mutex);
-                return false;
-            }
+        return tryWriteFile(path, reinterpret_cast<const uint8_t*>(content), strlen(content), portMAX_DELAY);
+    }
 
-            size_t written = file.print(content);
-            file.close();
+    /**
+     * @brief 写入二进制文件内容
+     * @param path 文件路径
+     * @param data 要写入的数据
+     * @param length 数据长度
+     * @return 写入是否成功
+     */
+    bool writeFile(const char* path, const uint8_t* data, size_t length) {
+        return tryWriteFile(path, data, length, portMAX_DELAY);
+    }
 
-            bool success = written == strlen(content);
-            if (!success) {
-                ESP_LOGE(TAG, "Failed to write complete file: %s", path);
-            }
-            xSemaphoreGive(mutex);
-            return success;
+    /**
+     * @brief 在超时内写入文件内容
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 写入是否成功，超时返回false
+     */
+    bool tryWriteFile(const char* path, const char* content, uint32_t timeoutMs) {
+        return tryWriteFile(path, reinterpret_cast<const uint8_t*>(content), strlen(content), timeoutMs);
+    }
+
+    /**
+     * @brief 在超时内写入二进制文件内容
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 写入是否成功，超时返回false
+     */
+    bool tryWriteFile(const char* path, const uint8_t* data, size_t length, uint32_t timeoutMs) {
+        Lock lock(*this, pathLockOf(path), Access::WRITE, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout writing %s", path);
+            return false;
+        }
+
+        std::string temp = std::string(path) + TEMP_SUFFIX;
+        if (!writeRaw(temp.c_str(), data, length)) {
+            LittleFS.remove(temp.c_str());
+            return false;
+        }
+        if (!LittleFS.rename(temp.c_str(), path)) {
+            ESP_LOGE(TAG, "Failed to replace file: %s", path);
+            LittleFS.remove(temp.c_str());
+            return false;
+        }
+        touch(path);
+        return true;
+    }
+
+    /**
+     * @brief 在文件末尾追加数据，文件不存在时创建
+     * @note 不经过临时文件，复位时末尾可能留下不完整的数据，调用者需自行校验（如RingLog的记录CRC）
+     * @param path 文件路径
+     * @param data 要追加的数据
+     * @param length 数据长度
+     * @return 是否全部写入
+     */
+    bool appendFile(const char* path, const uint8_t* data, size_t length) {
+        Lock lock(*this, pathLockOf(path), Access::WRITE, portMAX_DELAY);
+        File file = LittleFS.open(path, "a");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open file for appending: %s", path);
+            return false;
+        }
+
+        size_t written = file.write(data, length);
+        file.close();
+        touch(path);
+        if (written != length) {
+            ESP_LOGE(TAG, "Failed to append to file: %s, %u of %u bytes", path, written, length);
+            return false;
         }
-        return false;
+        return true;
+    }
+
+    /**
+     * @brief 提交一组写入和删除
+     * @details 先写入全部临时文件，再写入日志（提交点），然后逐个重命名/删除，最后删除日志。
+     *          复位发生在提交点之前则全部不生效，之后则在下次挂载时继续完成。
+     *          提交期间独占文件系统，适合少量小文件（如配置）。
+     *          与逐个writeFile()相比多写一次日志，flash写入量不会减少，换取的是整批的原子性
+     * @note 上次提交的日志未能执行完时，先重试该日志，仍然失败则本次提交失败
+     * @param batch 写入批次
+     * @return 是否提交成功
+     */
+    bool commit(const FsWriteBatch& batch) {
+        return tryCommit(batch, portMAX_DELAY);
+    }
+
+    /**
+     * @brief 在超时内提交一组写入和删除
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 是否提交成功，超时返回false
+     */
+    bool tryCommit(const FsWriteBatch& batch, uint32_t timeoutMs) {
+        if (batch.empty()) {
+            return true;
+        }
+
+        Lock lock(*this, NO_PATH, Access::EXCLUSIVE, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout committing %u operations", batch.size());
+            return false;
+        }
+        return commitLocked(batch);
     }
 
     /**
@@ -130,49 +561,31 @@ class LittleFSController {
      * @return 文件大小（字节）
      */
     size_t getFileSize(const char* path) {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            File file = LittleFS.open(path, "r");
-            if (!file) {
-                ESP_LOGE(TAG, "Failed to open file: %s", path);
-                xSemaphoreGive(mutex);
-                return 0;
-            }
+        AssetManifest::Info info;
+        if (manifest.isReady() && manifest.covers(path)) {
+            return manifest.lookup(path, info) ? info.size : 0;
+        }
 
-            size_t size = file.size();
-            file.close();
-            xSemaphoreGive(mutex);
-            return size;
+        Lock lock(*this, pathLockOf(path), Access::READ, portMAX_DELAY);
+        File file = LittleFS.open(path, "r");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open file: %s", path);
+            return 0;
         }
-        return 0;
+
+        size_t size = file.size();
+        file.close();
+        return size;
     }
 
     /**
      * @brief 获取文件MIME类型
+     * @details 按扩展名（不区分大小写）在编译期完美哈希表中查找，额外类型通过MimeTypes::registerType()添加
      * @param path 文件路径
      * @return MIME类型字符串
      */
     const char* getMimeType(const char* path) {
-        const char* ext = strrchr(path, '.');
-        if (!ext) {
-            return "application/octet-stream";
-        }
-        ext = ext + 1;
-
-        if (strcasecmp(ext, "html") == 0) return "text/html";
-        if (strcasecmp(ext, "htm") == 0) return "text/html";
-        if (strcasecmp(ext, "css") == 0) return "text/css";
-        if (strcasecmp(ext, "js") == 0) return "application/javascript";
-        if (strcasecmp(ext, "json") == 0) return "application/json";
-        if (strcasecmp(ext, "png") == 0) return "image/png";
-        if (strcasecmp(ext, "jpg") == 0) return "image/jpeg";
-        if (strcasecmp(ext, "jpeg") == 0) return "image/jpeg";
-        if (strcasecmp(ext, "ico") == 0) return "image/x-icon";
-        if (strcasecmp(ext, "svg") == 0) return "image/svg+xml";
-        if (strcasecmp(ext, "txt") == 0) return "text/plain";
-        if (strcasecmp(ext, "pdf") == 0) return "application/pdf";
-        if (strcasecmp(ext, "zip") == 0) return "application/zip";
-
-        return "application/octet-stream";
+        return MimeTypes::lookup(path);
     }
 
     /**
@@ -182,79 +595,463 @@ class LittleFSController {
      */
     std::vector<std::string> listDir(const char* path = "/") {
         std::vector<std::string> files;
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            File root = LittleFS.open(path);
-            if (!root) {
-                ESP_LOGE(TAG, "Failed to open directory: %s", path);
-                xSemaphoreGive(mutex);
-                return files;
-            }
+        tryListDir(path, files, portMAX_DELAY);
+        return files;
+    }
 
-            if (!root.isDirectory()) {
-                ESP_LOGE(TAG, "Not a directory: %s", path);
-                root.close();
-                xSemaphoreGive(mutex);
-                return files;
-            }
+    /**
+     * @brief 在超时内列出目录内容
+     * @param path 目录路径
+     * @param files 输出文件和子目录的列表
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 是否成功，超时返回false
+     */
+    bool tryListDir(const char* path, std::vector<std::string>& files, uint32_t timeoutMs) {
+        files.clear();
+        Lock lock(*this, NO_PATH, Access::READ, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout listing %s", path);
+            return false;
+        }
 
-            File file = root.openNextFile();
-            while (file) {
-                files.push_back(file.name());
-                file = root.openNextFile();
+        char fullPath[MAX_PATH_LENGTH];
+        size_t length = 0;
+        if (!resolveDir(path, fullPath, length)) {
+            return false;
+        }
+        return walkLocked(fullPath, length, 0, 0, false, [&](const DirEntry& entry) {
+                   files.push_back(entry.name);
+                   return true;
+               }) != Walk::FAILED;
+    }
+
+    /**
+     * @brief 遍历目录，一次遍历得到每一项的名称、类型，以及可选的大小和修改时间
+     * @details 目录项在栈上的路径缓冲区中构造，不为每项分配内存。
+     * 类型取自目录项本身；大小和修改时间需要对每项stat，LittleFS的stat要从头查找所在目录，
+     * 遍历n项的总开销随n平方增长，只需要名称和类型时应将withStat设为false
+     * @param path 目录路径
+     * @param visitor 回调，在持有文件系统共享锁时调用，不能再调用LittleFSController的方法
+     * @param maxDepth 最大递归深度，0表示只遍历直接子项
+     * @param withStat 是否获取大小和修改时间，为false时两者都为0
+     * @return 是否成功（回调要求停止也算成功）
+     */
+    bool walkDir(const char* path, const DirVisitor& visitor, uint8_t maxDepth = 0, bool withStat = true) {
+        Lock lock(*this, NO_PATH, Access::READ, portMAX_DELAY);
+        char fullPath[MAX_PATH_LENGTH];
+        size_t length = 0;
+        if (!resolveDir(path, fullPath, length)) {
+            return false;
+        }
+        return walkLocked(fullPath, length, 0, maxDepth, withStat, visitor) != Walk::FAILED;
+    }
+
+    /**
+     * @brief 列出目录（可递归），目录及其子目录没有修改时直接返回缓存的结果
+     * @param path 目录路径
+     * @param maxDepth 最大递归深度，0表示只列出直接子项
+     * @return 目录项列表，失败返回nullptr；返回的列表不会再被修改，可以在锁外使用
+     */
+    FileList listDirCached(const char* path = "/", uint8_t maxDepth = 0) {
+        std::string dir = normalizeDir(path);
+        // 遍历前读取代数，遍历期间有修改时缓存的代数已过期，下次会重新遍历
+        uint32_t generation = getDirGeneration(dir.c_str());
+
+        if (xSemaphoreTake(cacheMutex, portMAX_DELAY) == pdTRUE) {
+            for (DirCacheEntry& entry : dirCache) {
+                if (entry.files && entry.generation == generation && entry.maxDepth == maxDepth && entry.path == dir) {
+                    entry.lastUsed = ++cacheClock;
+                    FileList files = entry.files;
+                    xSemaphoreGive(cacheMutex);
+                    return files;
+                }
             }
+            xSemaphoreGive(cacheMutex);
+        }
 
-            root.close();
-            xSemaphoreGive(mutex);
+        auto files = std::make_shared<std::vector<FileInfo>>();
+        bool success = walkDir(dir.c_str(), [&](const DirEntry& entry) {
+            files->push_back({entry.path, entry.size, entry.isDirectory, entry.mtime});
+            return true;
+        }, maxDepth);
+        if (!success) {
+            return nullptr;
+        }
+
+        if (xSemaphoreTake(cacheMutex, portMAX_DELAY) == pdTRUE) {
+            DirCacheEntry* slot = &dirCache[0];
+            for (DirCacheEntry& entry : dirCache) {
+                if (entry.lastUsed < slot->lastUsed) {
+                    slot = &entry;
+                }
+            }
+            *slot = {dir, maxDepth, generation, files, ++cacheClock};
+            xSemaphoreGive(cacheMutex);
         }
         return files;
     }
 
+    /**
+     * @brief 获取目录代数，目录或其任意子项被修改后代数增加
+     * @note 代数按路径哈希分组，不同目录可能共用一个计数，只会导致多余的缓存失效
+     */
+    uint32_t getDirGeneration(const char* path) {
+        std::string dir = normalizeDir(path);
+        return epoch.load() + dirGenerations[hashPath(dir.c_str(), dir.size()) % DIR_GENERATION_COUNT].load();
+    }
+
     /**
      * @brief 删除文件
      * @param path 文件路径
      * @return 删除是否成功
      */
     bool removeFile(const char* path) {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            bool success = LittleFS.remove(path);
-            if (!success) {
-                ESP_LOGE(TAG, "Failed to remove file: %s", path);
+        return tryRemoveFile(path, portMAX_DELAY);
+    }
+
+    /**
+     * @brief 在超时内删除文件
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 删除是否成功，超时返回false
+     */
+    bool tryRemoveFile(const char* path, uint32_t timeoutMs) {
+        Lock lock(*this, pathLockOf(path), Access::WRITE, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout removing %s", path);
+            return false;
+        }
+
+        bool success = LittleFS.remove(path);
+        if (success) {
+            touch(path);
+        } else {
+            ESP_LOGE(TAG, "Failed to remove file: %s", path);
+        }
+        return success;
+    }
+
+    /**
+     * @brief 创建目录，上级目录不存在时一并创建
+     * @param path 目录路径
+     * @return 目录是否存在（已存在也返回true）
+     */
+    bool mkdir(const char* path) {
+        return tryMkdir(path, portMAX_DELAY);
+    }
+
+    /**
+     * @brief 在超时内创建目录
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 目录是否存在，超时返回false
+     */
+    bool tryMkdir(const char* path, uint32_t timeoutMs) {
+        size_t length = strlen(path);
+        if (length == 0 || length >= MAX_PATH_LENGTH) {
+            ESP_LOGE(TAG, "Invalid directory path: %s", path);
+            return false;
+        }
+
+        Lock lock(*this, pathLockOf(path), Access::WRITE, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout creating %s", path);
+            return false;
+        }
+
+        // 逐级创建，每个新建的目录都更新代数和清单
+        char partial[MAX_PATH_LENGTH];
+        for (size_t i = 1; i <= length; i++) {
+            if (i < length && path[i] != '/') {
+                continue;
+            }
+            memcpy(partial, path, i);
+            partial[i] = '\0';
+            bool existed = LittleFS.exists(partial);
+            if (!LittleFS.mkdir(partial)) {
+                ESP_LOGE(TAG, "Failed to create directory: %s", partial);
+                return false;
+            }
+            if (!existed) {
+                touch(partial);
             }
-            xSemaphoreGive(mutex);
-            return success;
         }
-        return false;
+        return true;
+    }
+
+    /**
+     * @brief 删除空目录
+     * @param path 目录路径
+     * @return 删除是否成功
+     */
+    bool rmdir(const char* path) {
+        return tryRmdir(path, portMAX_DELAY);
+    }
+
+    /**
+     * @brief 在超时内删除空目录
+     * @param timeoutMs 等待锁的超时（毫秒）
+     * @return 删除是否成功，超时返回false
+     */
+    bool tryRmdir(const char* path, uint32_t timeoutMs) {
+        Lock lock(*this, pathLockOf(path), Access::WRITE, toTicks(timeoutMs));
+        if (!lock) {
+            ESP_LOGD(TAG, "Lock timeout removing %s", path);
+            return false;
+        }
+
+        bool success = LittleFS.rmdir(path);
+        if (success) {
+            touch(path);
+        } else {
+            ESP_LOGE(TAG, "Failed to remove directory: %s", path);
+        }
+        return success;
     }
 
     /**
      * @brief 格式化文件系统
-     * @return 格式化是否成功
+     * @param timeoutMs 等待已打开的读取器关闭的超时（毫秒）
+     * @return 格式化是否成功，读取器未在超时内关闭时返回false
+     */
+    bool format(uint32_t timeoutMs = DRAIN_TIMEOUT_MS) {
+        notifyMountListeners(MountEvent::UNMOUNTING);
+        bool success = false;
+        bool drained = withoutReaders(timeoutMs, [&]() {
+            success = LittleFS.format();
+            epoch++;
+            buildManifest();
+        });
+        if (!drained) {
+            return false;
+        }
+        if (!success) {
+            ESP_LOGE(TAG, "Failed to format filesystem");
+        } else {
+            ESP_LOGI(TAG, "Filesystem formatted successfully");
+        }
+        notifyMountListeners(isInitialized ? MountEvent::MOUNTED : MountEvent::UNMOUNTED);
+        return success;
+    }
+
+    /**
+     * @brief 卸载文件系统，直接写入分区镜像前调用
+     * @param timeoutMs 等待已打开的读取器关闭的超时（毫秒）
+     * @return 是否成功，读取器未在超时内关闭时返回false且保持挂载
      */
-    bool format() {
-        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
-            bool success = LittleFS.format();
-            if (!success) {
-                ESP_LOGE(TAG, "Failed to format filesystem");
+    bool unmount(uint32_t timeoutMs = DRAIN_TIMEOUT_MS) {
+        notifyMountListeners(MountEvent::UNMOUNTING);
+        bool drained = withoutReaders(timeoutMs, [this]() {
+            if (isInitialized) {
+                LittleFS.end();
+                isInitialized = false;
+                epoch++;
+                manifest.clear();
+                ESP_LOGI(TAG, "LittleFS unmounted");
+            }
+        });
+        if (drained) {
+            notifyMountListeners(MountEvent::UNMOUNTED);
+        }
+        return drained;
+    }
+
+    /**
+     * @brief 重新挂载文件系统，挂载失败时不格式化，保留分区内容
+     * @param timeoutMs 等待已打开的读取器关闭的超时（毫秒）
+     * @return 挂载是否成功，读取器未在超时内关闭时返回false且保持原挂载状态
+     */
+    bool remount(uint32_t timeoutMs = DRAIN_TIMEOUT_MS) {
+        return remount(FsWriteBatch(), timeoutMs);
+    }
+
+    /**
+     * @brief 重新挂载文件系统，并在通知挂载状态变化之前提交一组写入
+     * @details 用于写入分区镜像后恢复镜像之外的文件（如配置），监听者重新加载时看到的已是恢复后的内容
+     * @param restore 挂载成功后原子地提交的写入
+     * @param timeoutMs 等待已打开的读取器关闭的超时（毫秒）
+     * @return 挂载是否成功；restore提交失败时仍返回true，只记录错误
+     */
+    bool remount(const FsWriteBatch& restore, uint32_t timeoutMs = DRAIN_TIMEOUT_MS) {
+        notifyMountListeners(MountEvent::UNMOUNTING);
+        bool drained = withoutReaders(timeoutMs, [&]() {
+            if (isInitialized) {
+                LittleFS.end();
+                isInitialized = false;
+            }
+            isInitialized = LittleFS.begin(false, BASE_PATH, config.maxOpenFiles, PARTITION_LABEL);
+            epoch++;
+            if (isInitialized) {
+                ESP_LOGI(TAG, "LittleFS remounted, used %u of %u bytes", LittleFS.usedBytes(), LittleFS.totalBytes());
+                recoverJournal();
+                if (!restore.empty() && !commitLocked(restore)) {
+                    ESP_LOGE(TAG, "Failed to restore %u files after remount", restore.size());
+                }
+                buildManifest();
             } else {
-                ESP_LOGI(TAG, "Filesystem formatted successfully");
+                manifest.clear();
+                ESP_LOGE(TAG, "Failed to remount LittleFS");
             }
-            xSemaphoreGive(mutex);
-            return success;
+        });
+        if (!drained) {
+            return false;
+        }
+        notifyMountListeners(isInitialized ? MountEvent::MOUNTED : MountEvent::UNMOUNTED);
+        return isInitialized;
+    }
+
+    /**
+     * @brief 注册挂载状态变化回调，unmount()、remount()、format()前后调用
+     * @param listener 回调
+     * @return 回调ID，用于removeMountListener()
+     */
+    uint32_t addMountListener(MountListener listener) {
+        uint32_t id = 0;
+        if (xSemaphoreTake(listenerMutex, portMAX_DELAY) == pdTRUE) {
+            id = nextListenerId++;
+            mountListeners.push_back({id, std::move(listener)});
+            xSemaphoreGive(listenerMutex);
+        }
+        return id;
+    }
+
+    /**
+     * @brief 注销挂载状态变化回调，返回后回调不会再被调用
+     * @param id addMountListener()返回的ID
+     */
+    void removeMountListener(uint32_t id) {
+        if (xSemaphoreTake(listenerMutex, portMAX_DELAY) == pdTRUE) {
+            mountListeners.erase(
+                std::remove_if(
+                    mountListeners.begin(),
+                    mountListeners.end(),
+                    [id](const MountListenerEntry& entry) { return entry.id == id; }
+                ),
+                mountListeners.end()
+            );
+            xSemaphoreGive(listenerMutex);
         }
-        return false;
+    }
+
+    /**
+     * @brief 设置挂载参数，maxOpenFiles和formatOnFail在下次挂载时生效
+     */
+    void setConfig(const Config& mountConfig) {
+        Lock lock(*this, NO_PATH, Access::EXCLUSIVE, portMAX_DELAY);
+        setConfigLocked(mountConfig);
+    }
+
+    /**
+     * @brief 获取挂载参数
+     */
+    Config getConfig() {
+        Lock lock(*this, NO_PATH, Access::READ, portMAX_DELAY);
+        return config;
+    }
+
+    /**
+     * @brief 文件系统是否已挂载
+     */
+    bool isMounted() const {
+        return isInitialized;
+    }
+
+    /**
+     * @brief 获取锁等待统计
+     */
+    LockStats getLockStats() const {
+        return {sharedWait.snapshot(), exclusiveWait.snapshot()};
     }
 
     ~LittleFSController() {
         if (isInitialized) {
             LittleFS.end();
         }
-        if (mutex != nullptr) {
-            vSemaphoreDelete(mutex);
-            mutex = nullptr;
-        }
     }
 
    private:
+    static constexpr size_t NO_PATH = PATH_LOCK_COUNT;  // 不需要路径锁
+    static constexpr size_t DIR_GENERATION_COUNT = 16;  // 目录代数分组数
+    static constexpr size_t DIR_CACHE_SIZE = 4;         // 目录列表缓存项数
+    static constexpr uint32_t DRAIN_TIMEOUT_MS = 5000;  // 卸载前等待读取器关闭的默认超时
+    static constexpr uint32_t FNV_OFFSET = 2166136261u;
+    static constexpr uint32_t FNV_PRIME = 16777619u;
+
+    /**
+     * @brief 访问类型
+     */
+    enum class Access {
+        READ,      // 文件系统共享 + 路径共享
+        WRITE,     // 文件系统共享 + 路径独占
+        EXCLUSIVE  // 文件系统独占
+    };
+
+    /**
+     * @brief 作用域锁，按访问类型获取文件系统锁和路径锁，析构时释放
+     */
+    class Lock {
+       public:
+        Lock(LittleFSController& fs, size_t pathLock, Access access, TickType_t timeout)
+            : fs(fs), pathLock(pathLock), access(access) {
+            uint32_t start = micros();
+            locked = acquire(timeout);
+            LockWaitHistogram& histogram = access == Access::READ ? fs.sharedWait : fs.exclusiveWait;
+            histogram.record(micros() - start, locked);
+        }
+
+        ~Lock() {
+            if (!locked) {
+                return;
+            }
+            if (access == Access::EXCLUSIVE) {
+                fs.fsLock.unlock();
+                return;
+            }
+            if (pathLock != NO_PATH) {
+                if (access == Access::WRITE) {
+                    fs.pathLocks[pathLock].unlock();
+                } else {
+                    fs.pathLocks[pathLock].unlockShared();
+                }
+            }
+            fs.fsLock.unlockShared();
+        }
+
+        Lock(const Lock&) = delete;
+        Lock& operator=(const Lock&) = delete;
+
+        explicit operator bool() const {
+            return locked;
+        }
+
+       private:
+        bool acquire(TickType_t timeout) {
+            if (access == Access::EXCLUSIVE) {
+                return fs.fsLock.lock(timeout);
+            }
+
+            TickType_t start = xTaskGetTickCount();
+            if (!fs.fsLock.lockShared(timeout)) {
+                return false;
+            }
+            if (pathLock == NO_PATH) {
+                return true;
+            }
+
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            TickType_t rest = timeout == portMAX_DELAY ? portMAX_DELAY : (elapsed >= timeout ? 0 : timeout - elapsed);
+            FsRwLock& lock = fs.pathLocks[pathLock];
+            if (access == Access::WRITE ? lock.lock(rest) : lock.lockShared(rest)) {
+                return true;
+            }
+            fs.fsLock.unlockShared();
+            return false;
+        }
+
+        LittleFSController& fs;
+        size_t pathLock;
+        Access access;
+        bool locked = false;
+    };
+
     LittleFSController() {
         ESP_LOGI(TAG, "Creating LittleFSController instance");
     }
@@ -262,10 +1059,481 @@ class LittleFSController {
     LittleFSController(const LittleFSController&) = delete;
     LittleFSController& operator=(const LittleFSController&) = delete;
 
+    /**
+     * @brief 拒绝打开新的读取器，等已打开的读取器全部关闭后在独占锁内执行操作
+     * @details 读取器在两次read()之间不持有锁，卸载或格式化时仍打开的文件句柄会失效；
+     *          等待期间不持有锁，已打开的读取器可以继续读完
+     * @param timeoutMs 等待超时（毫秒）
+     * @param action 在独占锁内执行的操作
+     * @return 是否执行了操作，超时返回false
+     */
+    template <typename Action>
+    bool withoutReaders(uint32_t timeoutMs, Action&& action) {
+        draining++;
+        TickType_t start = xTaskGetTickCount();
+        while (true) {
+            if (openReaders == 0) {
+                Lock lock(*this, NO_PATH, Access::EXCLUSIVE, portMAX_DELAY);
+                // 检查后、加锁前可能还有读取器完成打开，持有独占锁时再确认一次
+                if (openReaders == 0) {
+                    action();
+                    draining--;
+                    return true;
+                }
+            }
+            if (xTaskGetTickCount() - start >= toTicks(timeoutMs)) {
+                draining--;
+                ESP_LOGE(TAG, "%u readers still open after %u ms", openReaders.load(), timeoutMs);
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+
+    /**
+     * @brief 依次调用挂载状态变化回调，调用期间持有回调互斥锁，注销回调会等待调用结束
+     */
+    void notifyMountListeners(MountEvent event) {
+        if (xSemaphoreTake(listenerMutex, portMAX_DELAY) == pdTRUE) {
+            for (const MountListenerEntry& entry : mountListeners) {
+                entry.callback(event);
+            }
+            xSemaphoreGive(listenerMutex);
+        }
+    }
+
+    /**
+     * @brief 提交一组写入和删除，调用者需持有独占锁
+     */
+    bool commitLocked(const FsWriteBatch& batch) {
+        // 新日志会覆盖未执行完的旧日志，必须先完成旧日志
+        if (!replayJournal()) {
+            ESP_LOGE(TAG, "Pending journal could not be applied");
+            return false;
+        }
+
+        // 日志每行一个操作：W <路径> 表示用临时文件替换，D <路径> 表示删除
+        std::string journal;
+        for (const FsWriteBatch::Operation& op : batch.operations) {
+            journal += op.remove ? "D " : "W ";
+            journal += op.path;
+            journal += '\n';
+
+            if (op.remove) continue;
+            std::string temp = op.path + TEMP_SUFFIX;
+            if (!writeRaw(temp.c_str(), reinterpret_cast<const uint8_t*>(op.content.data()), op.content.size())) {
+                discardBatch(batch);
+                return false;
+            }
+        }
+
+        std::string journalTemp = std::string(JOURNAL_PATH) + TEMP_SUFFIX;
+        if (!writeRaw(journalTemp.c_str(), reinterpret_cast<const uint8_t*>(journal.data()), journal.size()) ||
+            !LittleFS.rename(journalTemp.c_str(), JOURNAL_PATH)) {
+            ESP_LOGE(TAG, "Failed to write journal");
+            LittleFS.remove(journalTemp.c_str());
+            discardBatch(batch);
+            return false;
+        }
+
+        bool success = applyJournal(journal);
+        for (const FsWriteBatch::Operation& op : batch.operations) {
+            touch(op.path.c_str());
+        }
+        ESP_LOGD(TAG, "Committed %u operations", batch.size());
+        return success;
+    }
+
+    /**
+     * @brief 直接写入文件（截断后写入），调用者需持有锁
+     */
+    bool writeRaw(const char* path, const uint8_t* data, size_t length) {
+        File file = LittleFS.open(path, "w");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open file for writing: %s", path);
+            return false;
+        }
+
+        size_t written = file.write(data, length);
+        file.close();
+        if (written != length) {
+            ESP_LOGE(TAG, "Failed to write complete file: %s", path);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 执行日志中的操作，全部成功后删除日志，调用者需持有独占锁
+     * @details 有操作失败时保留日志，下次挂载或提交时重试；已完成的操作重复执行不会改变结果
+     * @return 是否全部成功
+     */
+    bool applyJournal(const std::string& journal) {
+        bool success = true;
+        size_t start = 0;
+        while (start < journal.size()) {
+            size_t end = journal.find('\n', start);
+            if (end == std::string::npos) end = journal.size();
+            if (end - start > 2) {
+                std::string path = journal.substr(start + 2, end - start - 2);
+                if (journal[start] == 'W') {
+                    // 临时文件不存在说明复位前已经替换过
+                    std::string temp = path + TEMP_SUFFIX;
+                    if (LittleFS.exists(temp.c_str()) && !LittleFS.rename(temp.c_str(), path.c_str())) {
+                        ESP_LOGE(TAG, "Failed to replace file: %s", path.c_str());
+                        success = false;
+                    }
+                } else if (LittleFS.exists(path.c_str()) && !LittleFS.remove(path.c_str())) {
+                    ESP_LOGE(TAG, "Failed to remove file: %s", path.c_str());
+                    success = false;
+                }
+            }
+            start = end + 1;
+        }
+
+        if (success) {
+            LittleFS.remove(JOURNAL_PATH);
+        } else {
+            ESP_LOGW(TAG, "Keeping journal for retry");
+        }
+        return success;
+    }
+
+    /**
+     * @brief 删除未提交批次的临时文件，调用者需持有独占锁
+     */
+    void discardBatch(const FsWriteBatch& batch) {
+        for (const FsWriteBatch::Operation& op : batch.operations) {
+            if (!op.remove) {
+                LittleFS.remove((op.path + TEMP_SUFFIX).c_str());
+            }
+        }
+    }
+
+    /**
+     * @brief 挂载后完成复位前已提交但未执行完的批次，并删除残留的临时文件，调用者需持有独占锁
+     */
+    void recoverJournal() {
+        std::string journalTemp = std::string(JOURNAL_PATH) + TEMP_SUFFIX;
+        if (LittleFS.exists(journalTemp.c_str())) {
+            // 日志未完成重命名，批次未提交
+            ESP_LOGW(TAG, "Discarding uncommitted batch");
+            LittleFS.remove(journalTemp.c_str());
+        }
+
+        // 日志保留时其中引用的临时文件还要用于重试，不能删除
+        if (replayJournal()) {
+            removeStaleTemps();
+        }
+    }
+
+    /**
+     * @brief 执行未完成的批次日志，调用者需持有独占锁
+     * @return 是否已没有待执行的日志
+     */
+    bool replayJournal() {
+        if (!LittleFS.exists(JOURNAL_PATH)) {
+            return true;
+        }
+
+        File file = LittleFS.open(JOURNAL_PATH, "r");
+        if (!file) {
+            ESP_LOGE(TAG, "Failed to open journal");
+            return false;
+        }
+        std::string journal(file.size(), '\0');
+        size_t length = file.read(reinterpret_cast<uint8_t*>(journal.data()), journal.size());
+        file.close();
+        if (length != journal.size()) {
+            ESP_LOGE(TAG, "Failed to read journal");
+            return false;
+        }
+
+        ESP_LOGW(TAG, "Replaying interrupted batch commit");
+        return applyJournal(journal);
+    }
+
+    /**
+     * @brief 删除writeFile()或提交中断后残留的临时文件，调用者需持有独占锁
+     * @details 遍历整个文件系统，只在挂载时执行；先于资源清单构建，临时文件不会进入清单。
+     * 只匹配保留的TEMP_SUFFIX，用户或Web资源中的".tmp"等文件不受影响
+     */
+    void removeStaleTemps() {
+        char fullPath[MAX_PATH_LENGTH];
+        size_t length = strlcpy(fullPath, BASE_PATH, sizeof(fullPath));
+        size_t suffixLength = strlen(TEMP_SUFFIX);
+        std::vector<std::string> stale;
+        walkLocked(fullPath, length, 0, UINT8_MAX, false, [&](const DirEntry& entry) {
+            size_t nameLength = strlen(entry.name);
+            if (!entry.isDirectory && nameLength > suffixLength &&
+                strcmp(entry.name + nameLength - suffixLength, TEMP_SUFFIX) == 0) {
+                stale.push_back(entry.path);
+            }
+            return true;
+        });
+
+        for (const std::string& path : stale) {
+            ESP_LOGW(TAG, "Removing stale temp file: %s", path.c_str());
+            LittleFS.remove(path.c_str());
+        }
+    }
+
+    struct BufferDeleter {
+        void operator()(uint8_t* buffer) const {
+            heap_caps_free(buffer);
+        }
+    };
+    using BufferPtr = std::unique_ptr<uint8_t, BufferDeleter>;
+
+    /**
+     * @brief 分配流式读取缓冲区，按配置优先使用PSRAM
+     */
+    uint8_t* allocateBuffer(size_t size) const {
+        void* buffer = nullptr;
+        if (config.psramBuffers) {
+            buffer = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (!buffer) {
+            buffer = heap_caps_malloc(size, MALLOC_CAP_8BIT);
+        }
+        return static_cast<uint8_t*>(buffer);
+    }
+
+    void setConfigLocked(const Config& mountConfig) {
+        config = mountConfig;
+        if (config.maxOpenFiles == 0) {
+            config.maxOpenFiles = 1;
+        }
+        if (config.readAhead == 0) {
+            config.readAhead = 1;
+        }
+    }
+
+    /**
+     * @brief 打印挂载参数和littlefs的编译期配置
+     */
+    void logMountOptions() {
+        ESP_LOGI(
+            TAG,
+            "Max open files %u, read ahead %u blocks, %s buffers, used %u of %u bytes",
+            config.maxOpenFiles,
+            config.readAhead,
+            config.psramBuffers ? "PSRAM" : "internal",
+            LittleFS.usedBytes(),
+            LittleFS.totalBytes()
+        );
+#if defined(CONFIG_LITTLEFS_CACHE_SIZE) && defined(CONFIG_LITTLEFS_LOOKAHEAD_SIZE)
+        ESP_LOGI(
+            TAG,
+            "littlefs build options: read %u, prog %u, cache %u, lookahead %u, block cycles %d",
+            CONFIG_LITTLEFS_READ_SIZE,
+            CONFIG_LITTLEFS_WRITE_SIZE,
+            CONFIG_LITTLEFS_CACHE_SIZE,
+            CONFIG_LITTLEFS_LOOKAHEAD_SIZE,
+            CONFIG_LITTLEFS_BLOCK_CYCLES
+        );
+#endif
+    }
+
+    /**
+     * @brief 目录遍历结果
+     */
+    enum class Walk {
+        DONE,     // 遍历完成
+        STOPPED,  // 回调要求停止
+        FAILED    // 无法打开目录
+    };
+
+    /**
+     * @brief 挂载状态变化回调项
+     */
+    struct MountListenerEntry {
+        uint32_t id;             // 回调ID
+        MountListener callback;  // 回调
+    };
+
+    /**
+     * @brief 目录列表缓存项
+     */
+    struct DirCacheEntry {
+        std::string path;     // 目录路径
+        uint8_t maxDepth;     // 递归深度
+        uint32_t generation;  // 列出时的目录代数
+        FileList files;       // 目录项
+        uint32_t lastUsed;    // 最近使用时间（LRU）
+    };
+
+    /**
+     * @brief 把目录路径转换为VFS路径，调用者需持有锁
+     */
+    bool resolveDir(const char* path, char* fullPath, size_t& length) {
+        if (!isInitialized) {
+            ESP_LOGE(TAG, "Filesystem not mounted");
+            return false;
+        }
+        std::string dir = normalizeDir(path);
+        int n = snprintf(fullPath, MAX_PATH_LENGTH, "%s%s", BASE_PATH, dir == "/" ? "" : dir.c_str());
+        if (n < 0 || static_cast<size_t>(n) >= MAX_PATH_LENGTH) {
+            ESP_LOGE(TAG, "Path too long: %s", path);
+            return false;
+        }
+        length = n;
+        return true;
+    }
+
+    /**
+     * @brief 递归遍历目录，子项路径就地追加到fullPath，返回前恢复
+     * @param withStat 是否stat每一项以获取大小和修改时间；目录项未给出类型时总是stat
+     */
+    Walk walkLocked(char* fullPath, size_t length, uint8_t depth, uint8_t maxDepth, bool withStat, const DirVisitor& visitor) {
+        DIR* dir = opendir(fullPath);
+        if (dir == nullptr) {
+            ESP_LOGE(TAG, "Failed to open directory: %s", fullPath + strlen(BASE_PATH));
+            return Walk::FAILED;
+        }
+
+        Walk result = Walk::DONE;
+        while (struct dirent* item = readdir(dir)) {
+            if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0) {
+                continue;
+            }
+            size_t nameLength = strlen(item->d_name);
+            if (length + 1 + nameLength >= MAX_PATH_LENGTH) {
+                ESP_LOGW(TAG, "Skipping entry with long path: %s", item->d_name);
+                continue;
+            }
+            fullPath[length] = '/';
+            memcpy(fullPath + length + 1, item->d_name, nameLength + 1);
+
+            DirEntry entry{item->d_name, fullPath + strlen(BASE_PATH), 0, item->d_type == DT_DIR, 0, depth};
+            struct stat info;
+            if ((withStat || item->d_type == DT_UNKNOWN) && stat(fullPath, &info) == 0) {
+                entry.isDirectory = S_ISDIR(info.st_mode);
+                entry.size = entry.isDirectory ? 0 : info.st_size;
+                entry.mtime = info.st_mtime;
+            }
+
+            if (!visitor(entry)) {
+                result = Walk::STOPPED;
+                break;
+            }
+            if (entry.isDirectory && depth < maxDepth &&
+                walkLocked(fullPath, length + 1 + nameLength, depth + 1, maxDepth, withStat, visitor) == Walk::STOPPED) {
+                result = Walk::STOPPED;
+                break;
+            }
+        }
+
+        fullPath[length] = '\0';
+        closedir(dir);
+        return result;
+    }
+
+    /**
+     * @brief 规范化目录路径：以'/'开头，除根目录外不以'/'结尾
+     */
+    static std::string normalizeDir(const char* path) {
+        std::string dir = path[0] == '/' ? path : std::string("/") + path;
+        while (dir.size() > 1 && dir.back() == '/') {
+            dir.pop_back();
+        }
+        return dir;
+    }
+
+    /**
+     * @brief 遍历MANIFEST_ROOT重建资源清单，调用者需持有锁
+     */
+    void buildManifest() {
+        if (!isInitialized) {
+            manifest.clear();
+            return;
+        }
+
+        uint32_t start = micros();
+        char fullPath[MAX_PATH_LENGTH];
+        size_t length = snprintf(fullPath, sizeof(fullPath), "%s%s", BASE_PATH, MANIFEST_ROOT);
+        struct stat info;
+        bool hasRoot = stat(fullPath, &info) == 0 && S_ISDIR(info.st_mode);
+        manifest.rebuild([&](auto&& add) {
+            if (!hasRoot) {
+                return;
+            }
+            add(MANIFEST_ROOT, 0, info.st_mtime, true);
+            walkLocked(fullPath, length, 0, MANIFEST_DEPTH, true, [&](const DirEntry& entry) {
+                add(entry.path, entry.size, entry.mtime, entry.isDirectory);
+                return true;
+            });
+        });
+        ESP_LOGI(TAG, "Asset manifest: %u entries in %u us", manifest.size(), micros() - start);
+    }
+
+    /**
+     * @brief 修改path后更新资源清单并递增其所有上级目录的代数
+     */
+    void touch(const char* path) {
+        if (manifest.covers(path)) {
+            char fullPath[MAX_PATH_LENGTH];
+            snprintf(fullPath, sizeof(fullPath), "%s%s", BASE_PATH, path);
+            struct stat info;
+            bool exists = stat(fullPath, &info) == 0;
+            manifest.update(path, exists, exists ? info.st_size : 0, exists ? info.st_mtime : 0, exists && S_ISDIR(info.st_mode));
+        }
+
+        uint32_t hash = FNV_OFFSET;
+        for (size_t i = 0; path[i]; i++) {
+            // hash此时为path[0, i)的哈希，即以'/'结尾前的上级目录
+            if (path[i] == '/' && i > 0) {
+                dirGenerations[hash % DIR_GENERATION_COUNT]++;
+            }
+            hash = (hash ^ static_cast<uint8_t>(path[i])) * FNV_PRIME;
+            if (i == 0) {
+                dirGenerations[hash % DIR_GENERATION_COUNT]++;  // 根目录"/"
+            }
+        }
+    }
+
+    static uint32_t hashPath(const char* path, size_t length) {
+        uint32_t hash = FNV_OFFSET;
+        for (size_t i = 0; i < length; i++) {
+            hash = (hash ^ static_cast<uint8_t>(path[i])) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief 路径对应的路径锁下标（FNV-1a哈希）
+     */
+    static size_t pathLockOf(const char* path) {
+        return hashPath(path, strlen(path)) % PATH_LOCK_COUNT;
+    }
+
+    /**
+     * @brief 毫秒超时转换为tick，portMAX_DELAY表示一直等待
+     */
+    static TickType_t toTicks(uint32_t timeoutMs) {
+        return timeoutMs == portMAX_DELAY ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs);
+    }
+
     /**
      * @brief 文件系统是否已初始化
      */
     bool isInitialized = false;
+    Config config;                          // 挂载参数
+    AssetManifest manifest{MANIFEST_ROOT};  // 资源清单
+
+    FsRwLock fsLock;                      // 文件系统锁
+    FsRwLock pathLocks[PATH_LOCK_COUNT];  // 路径锁
+    LockWaitHistogram sharedWait;         // 共享访问的锁等待时间
+    LockWaitHistogram exclusiveWait;      // 独占访问的锁等待时间
 
-    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    std::atomic<uint32_t> epoch{0};                              // 挂载、格式化时递增，使所有目录代数失效
+    std::atomic<uint32_t> openReaders{0};                        // 已打开的读取器数量
+    std::atomic<uint32_t> draining{0};                           // 等待读取器关闭的卸载、格式化操作数
+    std::atomic<uint32_t> dirGenerations[DIR_GENERATION_COUNT]{};  // 目录代数
+    DirCacheEntry dirCache[DIR_CACHE_SIZE]{};                    // 目录列表缓存
+    uint32_t cacheClock = 0;                                     // 缓存LRU时钟
+    SemaphoreHandle_t cacheMutex = xSemaphoreCreateMutex();      // 缓存互斥锁
+    std::vector<MountListenerEntry> mountListeners;              // 挂载状态变化回调
+    uint32_t nextListenerId = 1;                                 // 下一个回调ID
+    SemaphoreHandle_t listenerMutex = xSemaphoreCreateMutex();   // 回调互斥锁
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * @file MimeTypes.hpp
+ * @brief 按扩展名查找MIME类型
+ * @details 内置类型在编译期构建完美哈希，查找只需转小写、一次哈希和一次比较
+ */
+
+#pragma once
+
+#include <PerfectHash.hpp>
+#include <esp_log.h>
+#include <atomic>
+#include <cctype>
+#include <cstring>
+
+/**
+ * @brief 扩展名与MIME类型
+ */
+struct MimeType {
+    const char* extension;  // 小写扩展名，不含'.'
+    const char* type;       // MIME类型
+};
+
+/**
+ * @brief MIME类型表
+ *
+ * 扩展名不区分大小写。内置表之外的类型可以在初始化阶段通过registerType()添加，
+ * 添加的类型优先于内置类型。
+ */
+class MimeTypes {
+    static constexpr const char* TAG = "MimeTypes";
+
+   public:
+    static constexpr const char* DEFAULT_TYPE = "application/octet-stream";
+    static constexpr size_t MAX_EXTENSION_LENGTH = 15;
+    static constexpr size_t MAX_EXTRA_TYPES = 8;
+
+    static constexpr MimeType BUILTIN[] = {
+        {"html", "text/html"},
+        {"htm", "text/html"},
+        {"css", "text/css"},
+        {"js", "application/javascript"},
+        {"mjs", "application/javascript"},
+        {"json", "application/json"},
+        {"png", "image/png"},
+        {"jpg", "image/jpeg"},
+        {"jpeg", "image/jpeg"},
+        {"gif", "image/gif"},
+        {"webp", "image/webp"},
+        {"ico", "image/x-icon"},
+        {"svg", "image/svg+xml"},
+        {"txt", "text/plain"},
+        {"xml", "text/xml"},
+        {"pdf", "application/pdf"},
+        {"zip", "application/zip"},
+        {"gz", "application/gzip"},
+        {"wasm", "application/wasm"},
+        {"woff", "font/woff"},
+        {"woff2", "font/woff2"},
+        {"ttf", "font/ttf"},
+    };
+
+    /**
+     * @brief 查找文件的MIME类型
+     * @param path 文件路径或文件名
+     * @return MIME类型，未知扩展名返回DEFAULT_TYPE
+     */
+    static const char* lookup(const char* path) {
+        const char* dot = strrchr(path, '.');
+        const char* slash = strrchr(path, '/');
+        if (!dot || (slash && slash > dot)) {
+            return DEFAULT_TYPE;
+        }
+
+        char extension[MAX_EXTENSION_LENGTH + 1];
+        if (!toLower(dot + 1, extension)) {
+            return DEFAULT_TYPE;
+        }
+
+        size_t count = extraCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(extras[i].extension, extension) == 0) {
+                return extras[i].type;
+            }
+        }
+
+        int16_t index = TABLE[PerfectHash::fnv1a(extension, TABLE.seed)];
+        if (index >= 0 && strcmp(BUILTIN[index].extension, extension) == 0) {
+            return BUILTIN[index].type;
+        }
+        return DEFAULT_TYPE;
+    }
+
+    /**
+     * @brief 添加或覆盖一个类型，只应在初始化阶段调用
+     * @param extension 扩展名，不含'.'
+     * @param type MIME类型，必须是静态字符串
+     * @return 是否成功
+     */
+    static bool registerType(const char* extension, const char* type) {
+        size_t count = extraCount.load(std::memory_order_relaxed);
+        if (count >= MAX_EXTRA_TYPES) {
+            ESP_LOGE(TAG, "Too many MIME types, %s not registered", extension);
+            return false;
+        }
+
+        Extra& extra = extras[count];
+        if (!toLower(extension, extra.extension) || extra.extension[0] == '\0') {
+            ESP_LOGE(TAG, "Invalid extension: %s", extension);
+            return false;
+        }
+        extra.type = type;
+        extraCount.store(count + 1, std::memory_order_release);  // 先写完条目再发布
+        return true;
+    }
+
+   private:
+    struct Extra {
+        char extension[MAX_EXTENSION_LENGTH + 1];  // 小写扩展名
+        const char* type;                          // MIME类型
+    };
+
+    /**
+     * @brief 转为小写，超过最大长度时返回false
+     */
+    static bool toLower(const char* src, char* dst) {
+        size_t i = 0;
+        for (; src[i]; i++) {
+            if (i >= MAX_EXTENSION_LENGTH) {
+                return false;
+            }
+            dst[i] = static_cast<char>(tolower(static_cast<unsigned char>(src[i])));
+        }
+        dst[i] = '\0';
+        return true;
+    }
+
+    static constexpr size_t BUILTIN_COUNT = sizeof(BUILTIN) / sizeof(BUILTIN[0]);
+    static constexpr auto TABLE = PerfectHash::build<PerfectHash::nextPowerOfTwo(BUILTIN_COUNT * 4)>(
+        BUILTIN, [](const MimeType& entry, uint32_t seed) { return PerfectHash::fnv1a(entry.extension, seed); }
+    );
+    static_assert(TABLE.valid(), "Duplicate MIME extensions or no perfect hash seed");
+
+    static inline Extra extras[MAX_EXTRA_TYPES] = {};  // 初始化时添加的类型
+    static inline std::atomic<size_t> extraCount{0};   // 已添加的类型数
+};
\ No newline at end of file
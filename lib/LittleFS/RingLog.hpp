@@ -0,0 +1,546 @@
+/**
+ * @file RingLog.hpp
+ * @brief 基于LittleFS的分段环形日志
+ * @details 固定大小的段文件循环使用，只追加写入，每条记录带CRC，适合高频事件和指标
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "LittleFSController.hpp"
+
+/**
+ * @brief 分段环形日志
+ *
+ * - 记录先追加到RAM缓冲区，缓冲区满、调用flush()或自动刷新到期时一次追加到当前段
+ * - 当前段写满后换新段，段数超过上限时删除最旧的段，总占用约为 segmentSize * segmentCount
+ * - 每条记录有递增序号和CRC32；启动时扫描最后一段，复位时写了一半的记录之后换新段继续
+ * - 内存中保存每段的起始序号，按序号读取时直接定位到所在的段开始顺序扫描
+ *
+ * 记录格式：magic(2) 数据长度(2) 序号(4) CRC32(4) 数据
+ *
+ * @note 每个日志使用独立目录，目录中只能有该日志的段文件
+ */
+class RingLog {
+    static constexpr const char* TAG = "RingLog";
+
+   public:
+    // 读取回调，返回false时停止读取
+    using Visitor = std::function<bool(uint32_t seq, const uint8_t* data, size_t length)>;
+
+    static constexpr uint16_t RECORD_MAGIC = 0x52AA;
+
+    /**
+     * @param dir 日志目录
+     * @param segmentSize 段大小（字节）
+     * @param segmentCount 最多保留的段数
+     * @param bufferSize RAM缓冲区大小，也是单条记录（含头部）的上限
+     */
+    RingLog(const char* dir, size_t segmentSize = 32 * 1024, size_t segmentCount = 8, size_t bufferSize = 2048)
+        : dir(dir),
+          segmentSize(std::max(segmentSize, bufferSize)),
+          segmentCount(std::max<size_t>(segmentCount, 2)),
+          bufferSize(std::min<size_t>(bufferSize, HEADER_SIZE + UINT16_MAX)) {}
+
+    ~RingLog() {
+        if (mountListenerId != 0) {
+            LittleFSController::getInstance().removeMountListener(mountListenerId);
+        }
+        stopAutoFlush();
+        flush();
+        vSemaphoreDelete(mutex);
+    }
+
+    RingLog(const RingLog&) = delete;
+    RingLog& operator=(const RingLog&) = delete;
+
+    /**
+     * @brief 加载已有的段，恢复序号
+     * @details 文件系统卸载前写回缓冲区，卸载期间拒绝追加，重新挂载或格式化后重新扫描
+     * @return 是否成功
+     */
+    bool begin() {
+        if (mountListenerId == 0) {
+            mountListenerId = LittleFSController::getInstance().addMountListener(
+                [this](LittleFSController::MountEvent event) { onMountEvent(event); }
+            );
+        }
+
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+
+        buffer.reset(new (std::nothrow) uint8_t[bufferSize]);
+        if (!buffer) {
+            ESP_LOGE(TAG, "Failed to allocate %u byte buffer", bufferSize);
+            xSemaphoreGive(mutex);
+            return false;
+        }
+        used = 0;
+        segments.clear();
+        nextSeq = 1;
+        nextId = 0;
+
+        auto& fs = LittleFSController::getInstance();
+        if (!fs.mkdir(dir.c_str())) {
+            ESP_LOGE(TAG, "Failed to create log directory %s", dir.c_str());
+            xSemaphoreGive(mutex);
+            return false;
+        }
+
+        std::vector<uint32_t> ids;
+        for (const std::string& name : fs.listDir(dir.c_str())) {
+            uint32_t id;
+            if (parseSegmentName(name.c_str(), id)) {
+                ids.push_back(id);
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        if (!ids.empty()) {
+            nextId = ids.back() + 1;
+        }
+        while (ids.size() > segmentCount) {
+            fs.removeFile(segmentPath(ids.front()).c_str());
+            ids.erase(ids.begin());
+        }
+
+        std::vector<uint8_t> window(bufferSize * 2);
+        bool tailCorrupt = false;
+        // 从最后一段往前找到最后一条有效记录，没有有效记录的段直接删除
+        while (!ids.empty()) {
+            uint32_t lastSeq = 0;
+            size_t validSize = 0;
+            Scan result = scanSegment(ids.back(), SIZE_MAX, 0, window, validSize, [&](uint32_t seq, const uint8_t*, size_t) {
+                lastSeq = seq;
+                return true;
+            });
+            if (validSize > 0) {
+                nextSeq = lastSeq + 1;
+                tailCorrupt = result == Scan::CORRUPT;
+                break;
+            }
+            fs.removeFile(segmentPath(ids.back()).c_str());
+            ids.pop_back();
+        }
+
+        for (uint32_t id : ids) {
+            Segment segment{id, 0, fs.getFileSize(segmentPath(id).c_str())};
+            size_t validSize = 0;
+            scanSegment(id, SIZE_MAX, 0, window, validSize, [&](uint32_t seq, const uint8_t*, size_t) {
+                segment.firstSeq = seq;
+                return false;
+            });
+            segments.push_back(segment);
+        }
+
+        // 最后一段末尾有不完整的记录时不能继续追加
+        if (segments.empty() || tailCorrupt || segments.back().size >= segmentSize) {
+            if (tailCorrupt) {
+                ESP_LOGW(TAG, "%s: discarding incomplete record at end of segment %08x", dir.c_str(), segments.back().id);
+            }
+            rotate();
+        }
+
+        started = true;
+        ESP_LOGI(TAG, "%s: %u segments, records %u..%u", dir.c_str(), segments.size(), firstSeqLocked(), nextSeq - 1);
+        xSemaphoreGive(mutex);
+        return true;
+    }
+
+    /**
+     * @brief 追加一条记录
+     * @param data 记录数据
+     * @param length 数据长度
+     * @return 记录序号，失败返回0
+     */
+    uint32_t append(const uint8_t* data, size_t length) {
+        size_t recordSize = HEADER_SIZE + length;
+        if (recordSize > bufferSize) {
+            ESP_LOGE(TAG, "%s: record too large: %u bytes", dir.c_str(), length);
+            return 0;
+        }
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        if (!started) {
+            xSemaphoreGive(mutex);
+            return 0;
+        }
+
+        if (segments.back().size + used + recordSize > segmentSize) {
+            flushLocked();
+            rotate();
+        } else if (used + recordSize > bufferSize) {
+            flushLocked();
+        }
+
+        RecordHeader header{RECORD_MAGIC, static_cast<uint16_t>(length), nextSeq, 0};
+        header.crc = checksum(header, data);
+        memcpy(buffer.get() + used, &header, HEADER_SIZE);
+        memcpy(buffer.get() + used + HEADER_SIZE, data, length);
+        used += recordSize;
+        uint32_t seq = nextSeq++;
+
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+    /**
+     * @brief 追加一条文本记录
+     */
+    uint32_t append(const char* text) {
+        return append(reinterpret_cast<const uint8_t*>(text), strlen(text));
+    }
+
+    /**
+     * @brief 把缓冲区中的记录写入flash
+     * @return 是否成功
+     */
+    bool flush() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        bool success = flushLocked();
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 启动周期刷新任务
+     * @param intervalMs 刷新间隔
+     * @return 是否启动成功
+     */
+    bool startAutoFlush(uint32_t intervalMs = 1000) {
+        if (taskHandle != nullptr) {
+            ESP_LOGW(TAG, "Auto flush already running");
+            return true;
+        }
+
+        flushIntervalMs = intervalMs;
+        stopSignal = xSemaphoreCreateBinary();
+        done = xSemaphoreCreateBinary();
+        if (stopSignal == nullptr || done == nullptr) {
+            ESP_LOGE(TAG, "Failed to create auto flush signals");
+            deleteSignals();
+            return false;
+        }
+
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& log = *static_cast<RingLog*>(param);
+                // 等待停止信号超时即到了刷新时间；收到信号时当前的刷新已经完成，不会持有任何锁
+                while (xSemaphoreTake(log.stopSignal, pdMS_TO_TICKS(log.flushIntervalMs)) != pdTRUE) {
+                    log.flush();
+                }
+                xSemaphoreGive(log.done);
+                vTaskDelete(nullptr);
+            },
+            "ring_log",
+            4096,
+            this,
+            1,
+            &taskHandle
+        );
+
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create auto flush task");
+            taskHandle = nullptr;
+            deleteSignals();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 停止周期刷新任务，等待正在进行的刷新完成后返回
+     */
+    void stopAutoFlush() {
+        if (taskHandle == nullptr) {
+            return;
+        }
+        xSemaphoreGive(stopSignal);
+        xSemaphoreTake(done, portMAX_DELAY);
+        taskHandle = nullptr;
+        deleteSignals();
+    }
+
+    /**
+     * @brief 从指定序号开始顺序读取记录（包括尚未写入flash的记录）
+     * @param fromSeq 起始序号，早于最旧记录时从最旧记录开始
+     * @param visitor 回调
+     * @return 读取的记录数
+     */
+    size_t read(uint32_t fromSeq, const Visitor& visitor) {
+        // 复制段索引和缓冲区后释放锁，扫描期间不阻塞追加
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        std::deque<Segment> snapshot = segments;
+        std::vector<uint8_t> pending(buffer.get(), buffer.get() + used);
+        xSemaphoreGive(mutex);
+
+        size_t count = 0;
+        Visitor counted = [&](uint32_t seq, const uint8_t* data, size_t length) {
+            count++;
+            return visitor(seq, data, length);
+        };
+
+        // 定位到包含fromSeq的段
+        size_t start = 0;
+        while (start + 1 < snapshot.size() && snapshot[start + 1].size > 0 && snapshot[start + 1].firstSeq <= fromSeq) {
+            start++;
+        }
+
+        std::vector<uint8_t> window(bufferSize * 2);
+        for (size_t i = start; i < snapshot.size(); i++) {
+            if (snapshot[i].size == 0) continue;
+            size_t validSize = 0;
+            if (scanSegment(snapshot[i].id, snapshot[i].size, fromSeq, window, validSize, counted) == Scan::STOPPED) {
+                return count;
+            }
+        }
+
+        size_t consumed = 0;
+        parse(pending.data(), pending.size(), fromSeq, counted, consumed);
+        return count;
+    }
+
+    /**
+     * @brief 最旧记录的序号
+     */
+    uint32_t firstSeq() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        uint32_t seq = firstSeqLocked();
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+    /**
+     * @brief 下一条记录的序号
+     */
+    uint32_t getNextSeq() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        uint32_t seq = nextSeq;
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+   private:
+    /**
+     * @brief 文件系统挂载状态变化，重新挂载后段文件可能已被替换，段索引和序号需要重新扫描
+     */
+    void onMountEvent(LittleFSController::MountEvent event) {
+        if (event == LittleFSController::MountEvent::UNMOUNTING) {
+            flush();
+        } else if (event == LittleFSController::MountEvent::UNMOUNTED) {
+            if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+                started = false;
+                used = 0;
+                xSemaphoreGive(mutex);
+            }
+        } else {
+            begin();
+        }
+    }
+
+    /**
+     * @brief 删除自动刷新任务的信号量
+     */
+    void deleteSignals() {
+        if (stopSignal) vSemaphoreDelete(stopSignal);
+        if (done) vSemaphoreDelete(done);
+        stopSignal = done = nullptr;
+    }
+
+    struct RecordHeader {
+        uint16_t magic;   // RECORD_MAGIC
+        uint16_t length;  // 数据长度
+        uint32_t seq;     // 序号
+        uint32_t crc;     // 头部（crc为0）和数据的CRC32
+    };
+
+    static constexpr size_t HEADER_SIZE = sizeof(RecordHeader);
+    static_assert(HEADER_SIZE == 12, "Unexpected record header size");
+
+    /**
+     * @brief 段索引
+     */
+    struct Segment {
+        uint32_t id;        // 段编号，对应文件名
+        uint32_t firstSeq;  // 第一条记录的序号
+        size_t size;        // 已写入flash的字节数
+    };
+
+    /**
+     * @brief 扫描结果
+     */
+    enum class Scan {
+        END,      // 到达数据末尾
+        CORRUPT,  // 遇到损坏或不完整的记录
+        STOPPED   // 回调要求停止
+    };
+
+    /**
+     * @brief 解析连续内存中的完整记录
+     * @param consumed 输出已解析的字节数，不完整的记录留给下次
+     */
+    Scan parse(const uint8_t* data, size_t length, uint32_t fromSeq, const Visitor& visitor, size_t& consumed) const {
+        consumed = 0;
+        while (length - consumed >= HEADER_SIZE) {
+            RecordHeader header;
+            memcpy(&header, data + consumed, HEADER_SIZE);
+            if (header.magic != RECORD_MAGIC || HEADER_SIZE + header.length > bufferSize) {
+                return Scan::CORRUPT;
+            }
+            size_t recordSize = HEADER_SIZE + header.length;
+            if (length - consumed < recordSize) {
+                break;
+            }
+
+            const uint8_t* payload = data + consumed + HEADER_SIZE;
+            if (checksum(header, payload) != header.crc) {
+                return Scan::CORRUPT;
+            }
+            consumed += recordSize;
+            if (header.seq >= fromSeq && !visitor(header.seq, payload, header.length)) {
+                return Scan::STOPPED;
+            }
+        }
+        return Scan::END;
+    }
+
+    /**
+     * @brief 顺序扫描一个段文件
+     * @param limit 最多扫描的字节数
+     * @param window 读取窗口，大小至少为两条最大记录
+     * @param validSize 输出有效记录的总字节数
+     */
+    Scan scanSegment(
+        uint32_t id,
+        size_t limit,
+        uint32_t fromSeq,
+        std::vector<uint8_t>& window,
+        size_t& validSize,
+        const Visitor& visitor
+    ) const {
+        validSize = 0;
+        LittleFSController::Reader reader = LittleFSController::getInstance().openReader(segmentPath(id).c_str());
+        if (!reader) {
+            return Scan::CORRUPT;
+        }
+
+        size_t begin = 0;
+        size_t end = 0;
+        while (true) {
+            size_t consumed = 0;
+            Scan result = parse(window.data() + begin, end - begin, fromSeq, visitor, consumed);
+            begin += consumed;
+            validSize += consumed;
+            if (result != Scan::END) {
+                return result;
+            }
+
+            memmove(window.data(), window.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            size_t n = limit > 0 ? reader.read(window.data() + end, std::min(window.size() - end, limit)) : 0;
+            if (n == 0) {
+                return end == 0 ? Scan::END : Scan::CORRUPT;
+            }
+            end += n;
+            limit -= n;
+        }
+    }
+
+    static uint32_t checksum(RecordHeader header, const uint8_t* data) {
+        header.crc = 0;
+        uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), HEADER_SIZE);
+        return esp_rom_crc32_le(crc, data, header.length);
+    }
+
+    /**
+     * @brief 写入缓冲区，调用者需持有锁；写入失败时丢弃缓冲区中的记录，避免阻塞后续追加
+     */
+    bool flushLocked() {
+        if (used == 0) {
+            return true;
+        }
+
+        Segment& segment = segments.back();
+        bool success = LittleFSController::getInstance().appendFile(segmentPath(segment.id).c_str(), buffer.get(), used);
+        if (success) {
+            segment.size += used;
+        } else {
+            ESP_LOGE(TAG, "%s: flush failed, dropped %u bytes", dir.c_str(), used);
+        }
+        used = 0;
+        return success;
+    }
+
+    /**
+     * @brief 换新段，超出段数上限时删除最旧的段，调用者需持有锁
+     */
+    void rotate() {
+        segments.push_back({nextId++, nextSeq, 0});
+        while (segments.size() > segmentCount) {
+            LittleFSController::getInstance().removeFile(segmentPath(segments.front().id).c_str());
+            segments.pop_front();
+        }
+    }
+
+    uint32_t firstSeqLocked() const {
+        for (const Segment& segment : segments) {
+            if (segment.size > 0) {
+                return segment.firstSeq;
+            }
+        }
+        return nextSeq;
+    }
+
+    std::string segmentPath(uint32_t id) const {
+        char name[16];
+        snprintf(name, sizeof(name), "/%08x.seg", id);
+        return dir + name;
+    }
+
+    static bool parseSegmentName(const char* name, uint32_t& id) {
+        if (strlen(name) != 12 || strcmp(name + 8, ".seg") != 0) {
+            return false;
+        }
+        char* end;
+        id = strtoul(name, &end, 16);
+        return end == name + 8;
+    }
+
+    std::string dir;                                    // 日志目录
+    size_t segmentSize;                                 // 段大小
+    size_t segmentCount;                                // 最多保留的段数
+    size_t bufferSize;                                  // 缓冲区大小
+    std::unique_ptr<uint8_t[]> buffer;                  // 未写入flash的记录
+    size_t used = 0;                                    // 缓冲区已用字节数
+    std::deque<Segment> segments;                       // 段索引，最后一段为当前段
+    uint32_t nextSeq = 1;                               // 下一条记录的序号
+    uint32_t nextId = 0;                                // 下一个段编号
+    bool started = false;                               // 是否已加载
+    uint32_t flushIntervalMs = 1000;                    // 自动刷新间隔
+    TaskHandle_t taskHandle = nullptr;                  // 自动刷新任务
+    SemaphoreHandle_t stopSignal = nullptr;             // 通知自动刷新任务退出
+    SemaphoreHandle_t done = nullptr;                   // 自动刷新任务退出信号
+    uint32_t mountListenerId = 0;                       // 挂载状态变化回调ID
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 互斥锁
+};
\ No newline at end of file
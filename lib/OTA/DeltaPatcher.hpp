@@ -0,0 +1,260 @@
+/**
+ * @file DeltaPatcher.hpp
+ * @brief 差分升级补丁应用
+ * @details 以正在运行的分区为旧镜像，流式应用bsdiff风格的补丁生成新镜像，补丁由tools/ota_delta.py生成
+ */
+
+#pragma once
+
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <mbedtls/md.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+/**
+ * @brief 差分补丁应用器
+ *
+ * 补丁格式（小端）：
+ * - 文件头48字节："DOTA"、版本(1)、保留(3)、旧镜像长度(4)、新镜像长度(4)、旧镜像SHA-256(32)
+ * - 之后为若干条记录，每条记录：
+ *   - 控制字段12字节：差分长度(4)、新增长度(4)、旧镜像偏移调整(4，有符号)
+ *   - 差分数据：新镜像字节 = 旧镜像字节 + 差分字节（从旧镜像当前位置读取，读取后位置前移）
+ *   - 新增数据：直接作为新镜像字节
+ *   - 记录结束后旧镜像位置加上偏移调整
+ *
+ * 差分数据中大部分为0，整个补丁通常再用gzip压缩后上传。
+ */
+class DeltaPatcher {
+    static constexpr const char* TAG = "DeltaPatcher";
+
+   public:
+    // 新镜像输出回调，返回false时停止
+    using Output = std::function<bool(const uint8_t* data, size_t length)>;
+
+    static constexpr uint8_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 48;
+    static constexpr size_t CONTROL_SIZE = 12;
+    static constexpr size_t SOURCE_BUFFER_SIZE = 1024;
+
+    /**
+     * @brief 判断数据是否以补丁魔数开头
+     */
+    static bool isPatch(const uint8_t* data, size_t length) {
+        return length >= 4 && memcmp(data, "DOTA", 4) == 0;
+    }
+
+    /**
+     * @brief 开始应用补丁
+     * @param sourcePartition 旧镜像所在分区（通常为正在运行的分区）
+     */
+    void begin(const esp_partition_t* sourcePartition) {
+        source = sourcePartition;
+        state = State::HEADER;
+        fieldPos = 0;
+        sourcePos = 0;
+        produced = 0;
+    }
+
+    /**
+     * @brief 输入一段补丁数据
+     * @param data 数据
+     * @param length 数据长度
+     * @param output 新镜像输出回调
+     * @return 是否成功
+     */
+    bool feed(const uint8_t* data, size_t length, const Output& output) {
+        while (length > 0 && state != State::ERROR) {
+            size_t n = 0;
+            switch (state) {
+                case State::HEADER:
+                    n = collect(header, HEADER_SIZE, data, length);
+                    if (fieldPos == HEADER_SIZE && !parseHeader()) {
+                        state = State::ERROR;
+                    }
+                    break;
+
+                case State::CONTROL:
+                    n = collect(control, CONTROL_SIZE, data, length);
+                    if (fieldPos == CONTROL_SIZE && !parseControl()) {
+                        state = State::ERROR;
+                    }
+                    break;
+
+                case State::DIFF:
+                    n = std::min({length, diffRemaining, SOURCE_BUFFER_SIZE});
+                    if (esp_partition_read(source, sourcePos, sourceBuffer, n) != ESP_OK) {
+                        ESP_LOGE(TAG, "Failed to read source at 0x%x", sourcePos);
+                        state = State::ERROR;
+                        break;
+                    }
+                    for (size_t i = 0; i < n; i++) {
+                        sourceBuffer[i] += data[i];
+                    }
+                    if (!emit(sourceBuffer, n, output)) break;
+                    sourcePos += n;
+                    diffRemaining -= n;
+                    if (diffRemaining == 0) nextSection();
+                    break;
+
+                case State::EXTRA:
+                    n = std::min(length, extraRemaining);
+                    if (!emit(data, n, output)) break;
+                    extraRemaining -= n;
+                    if (extraRemaining == 0) nextSection();
+                    break;
+
+                case State::ERROR:
+                    break;
+            }
+            data += n;
+            length -= n;
+        }
+        return state != State::ERROR;
+    }
+
+    /**
+     * @brief 检查补丁是否完整应用
+     */
+    bool finish() const {
+        if (state != State::CONTROL || fieldPos != 0 || produced != targetSize) {
+            ESP_LOGE(TAG, "Incomplete patch, produced %u of %u bytes", produced, targetSize);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 是否因补丁错误而失败
+     */
+    bool hasFailed() const {
+        return state == State::ERROR;
+    }
+
+   private:
+    enum class State { HEADER, CONTROL, DIFF, EXTRA, ERROR };
+
+    static uint32_t readLe32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    /**
+     * @brief 把定长字段的字节收集到缓冲区
+     * @return 消耗的输入字节数
+     */
+    size_t collect(uint8_t* field, size_t size, const uint8_t* data, size_t length) {
+        size_t n = std::min(length, size - fieldPos);
+        memcpy(field + fieldPos, data, n);
+        fieldPos += n;
+        return n;
+    }
+
+    bool parseHeader() {
+        fieldPos = 0;
+        if (!isPatch(header, HEADER_SIZE) || header[4] != VERSION) {
+            ESP_LOGE(TAG, "Unsupported patch format");
+            return false;
+        }
+
+        sourceSize = readLe32(header + 8);
+        targetSize = readLe32(header + 12);
+        if (source == nullptr || sourceSize > source->size) {
+            ESP_LOGE(TAG, "Source image does not fit the running partition");
+            return false;
+        }
+        if (!verifySource(header + 16)) {
+            return false;
+        }
+
+        ESP_LOGI(TAG, "Applying patch: %u -> %u bytes", sourceSize, targetSize);
+        state = State::CONTROL;
+        return true;
+    }
+
+    /**
+     * @brief 校验正在运行的镜像与补丁的旧镜像一致
+     */
+    bool verifySource(const uint8_t* expected) {
+        mbedtls_md_context_t sha;
+        mbedtls_md_init(&sha);
+        mbedtls_md_setup(&sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&sha);
+
+        bool ok = true;
+        for (size_t offset = 0; offset < sourceSize && ok; offset += SOURCE_BUFFER_SIZE) {
+            size_t n = std::min(SOURCE_BUFFER_SIZE, sourceSize - offset);
+            ok = esp_partition_read(source, offset, sourceBuffer, n) == ESP_OK;
+            mbedtls_md_update(&sha, sourceBuffer, n);
+        }
+
+        uint8_t digest[32];
+        mbedtls_md_finish(&sha, digest);
+        mbedtls_md_free(&sha);
+
+        if (!ok || memcmp(digest, expected, sizeof(digest)) != 0) {
+            ESP_LOGE(TAG, "Patch was built against a different firmware");
+            return false;
+        }
+        return true;
+    }
+
+    bool parseControl() {
+        fieldPos = 0;
+        diffRemaining = readLe32(control);
+        extraRemaining = readLe32(control + 4);
+        seek = static_cast<int32_t>(readLe32(control + 8));
+
+        if (sourcePos + diffRemaining > sourceSize ||
+            produced + diffRemaining + extraRemaining > targetSize) {
+            ESP_LOGE(TAG, "Corrupt patch record");
+            return false;
+        }
+        nextSection();
+        return true;
+    }
+
+    /**
+     * @brief 进入当前记录的下一段，记录结束时调整旧镜像位置
+     */
+    void nextSection() {
+        if (diffRemaining > 0) {
+            state = State::DIFF;
+        } else if (extraRemaining > 0) {
+            state = State::EXTRA;
+        } else {
+            int64_t position = static_cast<int64_t>(sourcePos) + seek;
+            seek = 0;
+            if (position < 0 || position > sourceSize) {
+                ESP_LOGE(TAG, "Patch seeks outside the source image");
+                state = State::ERROR;
+                return;
+            }
+            sourcePos = position;
+            state = State::CONTROL;
+        }
+    }
+
+    bool emit(const uint8_t* data, size_t length, const Output& output) {
+        if (!output(data, length)) {
+            state = State::ERROR;
+            return false;
+        }
+        produced += length;
+        return true;
+    }
+
+    const esp_partition_t* source = nullptr;   // 旧镜像分区
+    State state = State::HEADER;
+    uint8_t header[HEADER_SIZE];                // 文件头
+    uint8_t control[CONTROL_SIZE];              // 当前记录的控制字段
+    size_t fieldPos = 0;                        // 定长字段已收集字节数
+    size_t sourceSize = 0;                      // 旧镜像长度
+    size_t targetSize = 0;                      // 新镜像长度
+    size_t sourcePos = 0;                       // 旧镜像读取位置
+    size_t produced = 0;                        // 已输出的新镜像字节数
+    size_t diffRemaining = 0;                   // 当前记录剩余差分字节数
+    size_t extraRemaining = 0;                  // 当前记录剩余新增字节数
+    int32_t seek = 0;                           // 当前记录的偏移调整
+    uint8_t sourceBuffer[SOURCE_BUFFER_SIZE];   // 旧镜像读取缓冲区
+};
\ No newline at end of file
@@ -0,0 +1,257 @@
+/**
+ * @file FlashWritePipeline.hpp
+ * @brief 双缓冲flash写入流水线
+ * @details 生产者填充一个缓冲区的同时，写入任务把另一个缓冲区写入flash，擦写与数据准备并行
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief 双缓冲写入流水线
+ *
+ * - 生产者（调用write()的任务）把数据拷贝进当前缓冲区，写满后交给写入任务
+ * - 写入任务调用sink把缓冲区写入flash，完成后归还缓冲区
+ * - 两个缓冲区都在写入时生产者阻塞，形成自然的背压
+ *
+ * @note write()/flush()/finish()/stop()必须在同一个任务中调用
+ */
+class FlashWritePipeline {
+    static constexpr const char* TAG = "FlashWritePipeline";
+
+   public:
+    // 写入回调，在写入任务中执行，返回false时流水线进入失败状态
+    using Sink = std::function<bool(const uint8_t* data, size_t length)>;
+
+    static constexpr size_t BUFFER_COUNT = 2;
+
+    /**
+     * @brief 流水线配置
+     */
+    struct Config {
+        size_t bufferSize = 16 * 1024;  // 单个缓冲区大小，应为4KB扇区的整数倍
+        uint32_t taskStackSize = 4096;  // 写入任务栈大小
+        UBaseType_t taskPriority = 2;   // 写入任务优先级
+    };
+
+    ~FlashWritePipeline() {
+        stop();
+    }
+
+    /**
+     * @brief 使用默认配置启动
+     */
+    bool start(Sink newSink) {
+        return start(std::move(newSink), Config());
+    }
+
+    /**
+     * @brief 分配缓冲区并启动写入任务
+     * @param newSink 写入回调
+     * @param newConfig 配置
+     * @return 是否成功
+     */
+    bool start(Sink newSink, const Config& newConfig) {
+        if (running) {
+            ESP_LOGW(TAG, "Pipeline already running");
+            return false;
+        }
+
+        config = newConfig;
+        sink = std::move(newSink);
+        failed = false;
+        current = -1;
+        currentLength = 0;
+
+        for (auto& buffer : buffers) {
+            // flash写入需要内部RAM缓冲区
+            buffer = static_cast<uint8_t*>(
+                heap_caps_malloc(config.bufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT)
+            );
+        }
+        freeQueue = xQueueCreate(BUFFER_COUNT, sizeof(int));
+        fullQueue = xQueueCreate(BUFFER_COUNT + 1, sizeof(Block));
+        done = xSemaphoreCreateBinary();
+
+        if (!buffers[0] || !buffers[1] || !freeQueue || !fullQueue || !done) {
+            ESP_LOGE(TAG, "Failed to allocate pipeline");
+            release();
+            return false;
+        }
+
+        for (int i = 0; i < static_cast<int>(BUFFER_COUNT); i++) {
+            xQueueSend(freeQueue, &i, 0);
+        }
+
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& pipeline = *static_cast<FlashWritePipeline*>(param);
+                pipeline.writerTask();
+            },
+            "flash_writer",
+            config.taskStackSize,
+            this,
+            config.taskPriority,
+            nullptr
+        );
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create writer task");
+            release();
+            return false;
+        }
+
+        running = true;
+        return true;
+    }
+
+    /**
+     * @brief 写入数据，缓冲区写满时提交给写入任务
+     * @return 是否成功
+     */
+    bool write(const uint8_t* data, size_t length) {
+        while (length > 0) {
+            if (failed) {
+                return false;
+            }
+            if (current < 0 && !acquire()) {
+                return false;
+            }
+
+            size_t n = std::min(length, config.bufferSize - currentLength);
+            memcpy(buffers[current] + currentLength, data, n);
+            currentLength += n;
+            data += n;
+            length -= n;
+
+            if (currentLength == config.bufferSize) {
+                submit();
+            }
+        }
+        return !failed;
+    }
+
+    /**
+     * @brief 提交当前未写满的缓冲区
+     */
+    void flush() {
+        if (current >= 0 && currentLength > 0) {
+            submit();
+        }
+    }
+
+    /**
+     * @brief 提交剩余数据并等待全部写入完成，之后写入任务退出
+     * @return 全部数据是否写入成功
+     */
+    bool finish() {
+        if (!running) {
+            return false;
+        }
+
+        flush();
+        Block stopBlock = {-1, 0};
+        xQueueSend(fullQueue, &stopBlock, portMAX_DELAY);
+        xSemaphoreTake(done, portMAX_DELAY);
+        release();
+        return !failed;
+    }
+
+    /**
+     * @brief 放弃未写入的数据并停止写入任务
+     */
+    void stop() {
+        if (!running) {
+            return;
+        }
+
+        failed = true;  // 写入任务跳过剩余数据
+        current = -1;
+        Block stopBlock = {-1, 0};
+        xQueueSend(fullQueue, &stopBlock, portMAX_DELAY);
+        xSemaphoreTake(done, portMAX_DELAY);
+        release();
+    }
+
+    /**
+     * @brief 是否已失败
+     */
+    bool hasFailed() const {
+        return failed;
+    }
+
+   private:
+    struct Block {
+        int index;      // 缓冲区下标，-1表示停止
+        size_t length;  // 数据长度
+    };
+
+    bool acquire() {
+        // 等待期间写入任务可能失败，定期检查避免永久阻塞
+        while (xQueueReceive(freeQueue, &current, pdMS_TO_TICKS(100)) != pdTRUE) {
+            if (failed) {
+                current = -1;
+                return false;
+            }
+        }
+        currentLength = 0;
+        return true;
+    }
+
+    void submit() {
+        Block block = {current, currentLength};
+        xQueueSend(fullQueue, &block, portMAX_DELAY);
+        current = -1;
+        currentLength = 0;
+    }
+
+    void writerTask() {
+        Block block;
+        while (xQueueReceive(fullQueue, &block, portMAX_DELAY) == pdTRUE) {
+            if (block.index < 0) {
+                break;
+            }
+            if (!failed && !sink(buffers[block.index], block.length)) {
+                ESP_LOGE(TAG, "Sink failed, dropping remaining data");
+                failed = true;
+            }
+            xQueueSend(freeQueue, &block.index, portMAX_DELAY);
+        }
+
+        xSemaphoreGive(done);
+        vTaskDelete(nullptr);
+    }
+
+    void release() {
+        for (auto& buffer : buffers) {
+            heap_caps_free(buffer);
+            buffer = nullptr;
+        }
+        if (freeQueue) vQueueDelete(freeQueue);
+        if (fullQueue) vQueueDelete(fullQueue);
+        if (done) vSemaphoreDelete(done);
+        freeQueue = fullQueue = nullptr;
+        done = nullptr;
+        running = false;
+    }
+
+    Config config;
+    Sink sink;
+    uint8_t* buffers[BUFFER_COUNT] = {};
+    QueueHandle_t freeQueue = nullptr;  // 空闲缓冲区下标
+    QueueHandle_t fullQueue = nullptr;  // 待写入的缓冲区
+    SemaphoreHandle_t done = nullptr;   // 写入任务退出信号
+    int current = -1;                   // 生产者当前持有的缓冲区
+    size_t currentLength = 0;           // 当前缓冲区已填充长度
+    std::atomic<bool> failed{false};
+    bool running = false;
+};
\ No newline at end of file
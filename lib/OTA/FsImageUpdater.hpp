@@ -0,0 +1,453 @@
+/**
+ * @file FsImageUpdater.hpp
+ * @brief 文件系统镜像升级
+ * @details 把mklittlefs生成的LittleFS镜像流式写入spiffs分区，写入完成后重新挂载，无需USB烧录也无需重启
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <KvStore.hpp>
+#include <LittleFSController.hpp>
+#include <Preferences.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <mbedtls/md.h>
+#include <string>
+#include <vector>
+#include "FlashWritePipeline.hpp"
+#include "GzipInflater.hpp"
+#include "OtaController.hpp"
+
+/**
+ * @brief 文件系统镜像升级器
+ *
+ * 数据流：上传数据 →（gzip镜像先解压）→ 双缓冲流水线 → 写入任务（擦除、写入分区并计算SHA-256）
+ *
+ * - 开始时卸载文件系统，结束后重新挂载，挂载成功才算升级成功
+ * - 配置文件（KvStore::DEFAULT_PATH及preserveFile()添加的文件）在卸载前读出，
+ *   重新挂载后、KvStore等重新加载之前写回，不会被镜像中的同名文件或空白覆盖
+ * - 按64KB块擦除；块内已经是空白（全0xFF）时跳过擦除，全0xFF的扇区跳过写入，
+ *   mklittlefs镜像大部分是空白，写入时间主要取决于实际文件大小
+ * - 镜像直接覆盖原分区，任何失败都会尝试重新挂载；分区已被部分改写而无法挂载时，
+ *   进度中fsUnusable为true，文件系统保持卸载，需要重新上传有效镜像
+ * - 开始写入分区前在NVS中记录写入未完成，重新挂载成功后清除；写入中途失败或掉电后重启时，
+ *   imageWritePending()为true，启动时应以formatOnFail=false挂载，避免格式化分区
+ *
+ * begin()/write()/finish()/abort()必须在同一个任务中调用。
+ */
+class FsImageUpdater {
+    static constexpr const char* TAG = "FsImageUpdater";
+    static constexpr const char* NVS_NAMESPACE = "fs_image";   // 写入状态的NVS命名空间
+    static constexpr const char* NVS_PENDING_KEY = "pending";  // 镜像写入未完成标记
+
+   public:
+    static constexpr size_t FLASH_SECTOR_SIZE = 4096;
+    static constexpr size_t FLASH_BLOCK_SIZE = 64 * 1024;  // 擦除块大小
+
+    static FsImageUpdater& getInstance() {
+        static FsImageUpdater instance;
+        return instance;
+    }
+
+    /**
+     * @brief 上次镜像写入是否未完成（分区可能已被部分改写），启动时用于决定挂载失败时是否格式化
+     */
+    static bool imageWritePending() {
+        Preferences preferences;
+        if (!preferences.begin(NVS_NAMESPACE, true)) {
+            return false;
+        }
+        bool pending = preferences.getBool(NVS_PENDING_KEY, false);
+        preferences.end();
+        return pending;
+    }
+
+    /**
+     * @brief 开始写入镜像
+     * @param uploadSize 上传数据大小，0表示未知
+     * @param expectedSha256 期望的镜像（解压后）SHA-256，nullptr表示不校验
+     * @return 是否成功
+     */
+    bool begin(size_t uploadSize = 0, const char* expectedSha256 = nullptr) {
+        if (active) {
+            ESP_LOGW(TAG, "Aborting unfinished update");
+            abort();
+        }
+
+        setProgress([&](OtaProgress& p) {
+            p = {};
+            p.phase = OtaPhase::RECEIVING;
+            p.total = uploadSize;
+        });
+        actual[0] = '\0';
+        expected[0] = '\0';
+        if (expectedSha256) {
+            if (strlen(expectedSha256) != OtaController::SHA256_HEX_LENGTH) {
+                return fail("Invalid SHA-256");
+            }
+            strlcpy(expected, expectedSha256, sizeof(expected));
+        }
+
+        partition = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, LittleFSController::PARTITION_LABEL
+        );
+        if (partition == nullptr) {
+            return fail("No filesystem partition");
+        }
+        if (uploadSize > partition->size) {
+            return fail("Image too large");
+        }
+
+        if (!readPreserved()) {
+            return fail("Failed to read preserved files");
+        }
+        if (!LittleFSController::getInstance().unmount()) {
+            preserved.clear();
+            return fail("Unmount failed, files still open");
+        }
+        setImageWritePending(true);
+
+        mbedtls_md_init(&sha);
+        mbedtls_md_setup(&sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&sha);
+        flashOffset = 0;
+        erasedTo = 0;
+        skippedBlocks = 0;
+        formatChecked = false;
+        compressed = false;
+
+        if (!pipeline.start([this](const uint8_t* data, size_t length) {
+                return writePartition(data, length);
+            })) {
+            mbedtls_md_free(&sha);
+            remount();
+            return fail("Out of memory");
+        }
+
+        startMs = millis();
+        active = true;
+        ESP_LOGI(TAG, "Filesystem update started, partition: %s, upload size: %u", partition->label, uploadSize);
+        return true;
+    }
+
+    /**
+     * @brief 写入一段上传数据，gzip镜像边解压边写入
+     * @return 是否成功
+     */
+    bool write(const uint8_t* data, size_t length) {
+        if (!active) {
+            return false;
+        }
+
+        if (!formatChecked) {
+            formatChecked = true;
+            if (GzipInflater::isGzip(data, length)) {
+                if (!inflater.begin()) {
+                    abortSession();
+                    remount();
+                    return fail("Out of memory");
+                }
+                compressed = true;
+                setProgress([](OtaProgress& p) { p.compressed = true; });
+            }
+        }
+
+        setProgress([&](OtaProgress& p) { p.received += length; });
+        bool ok;
+        if (compressed) {
+            ok = inflater.feed(data, length, [this](const uint8_t* out, size_t outLength) {
+                return pipeline.write(out, outLength);
+            });
+        } else {
+            ok = pipeline.write(data, length);
+        }
+        if (!ok) {
+            bool writeFailed = pipeline.hasFailed();
+            abortSession();
+            remount();
+            return fail(writeFailed ? "Write failed" : "Decompression failed");
+        }
+        return true;
+    }
+
+    /**
+     * @brief 结束写入：等待写入完成，校验SHA-256并重新挂载文件系统
+     * @return 是否成功
+     */
+    bool finish() {
+        if (!active) {
+            return false;
+        }
+
+        if (compressed && !inflater.finish()) {
+            abortSession();
+            remount();
+            return fail("Decompression failed");
+        }
+        if (!pipeline.finish()) {
+            abortSession();
+            remount();
+            return fail("Write failed");
+        }
+        inflater.end();
+        active = false;
+
+        OtaProgress result = getProgress();
+        if (result.total && result.received != result.total) {
+            mbedtls_md_free(&sha);
+            remount();
+            return fail("Incomplete image");
+        }
+
+        uint8_t digest[32];
+        mbedtls_md_finish(&sha, digest);
+        mbedtls_md_free(&sha);
+        for (size_t i = 0; i < sizeof(digest); i++) {
+            snprintf(actual + i * 2, 3, "%02x", digest[i]);
+        }
+        if (expected[0] && strcasecmp(expected, actual) != 0) {
+            ESP_LOGE(TAG, "SHA-256 mismatch, expected %s, got %s", expected, actual);
+            remount();
+            return fail("SHA-256 mismatch");
+        }
+
+        if (!remount()) {
+            return fail("Invalid filesystem image");
+        }
+
+        setProgress([&](OtaProgress& p) {
+            p.elapsedMs = millis() - startMs;
+            p.kbps = p.elapsedMs ? (p.written / 1024.0f) / (p.elapsedMs / 1000.0f) : 0;
+            p.phase = OtaPhase::DONE;
+            result = p;
+        });
+        ESP_LOGI(
+            TAG,
+            "Filesystem updated: %u bytes in %u ms (%.1f KB/s), skipped %u erase blocks, sha256: %s",
+            result.written,
+            result.elapsedMs,
+            result.kbps,
+            skippedBlocks,
+            actual
+        );
+        return true;
+    }
+
+    /**
+     * @brief 放弃当前写入，尝试重新挂载原文件系统
+     * @param reason 原因
+     */
+    void abort(const char* reason = "Aborted") {
+        if (!active) {
+            return;
+        }
+        abortSession();
+        remount();
+        fail(reason);
+    }
+
+    /**
+     * @brief 添加写入镜像前后需要保留的文件，begin()之前调用
+     * @param path 文件路径
+     */
+    void preserveFile(const char* path) {
+        for (const std::string& existing : preservedPaths) {
+            if (existing == path) {
+                return;
+            }
+        }
+        preservedPaths.push_back(path);
+    }
+
+    /**
+     * @brief 获取进度（可在任意任务中调用）
+     */
+    OtaProgress getProgress() {
+        OtaProgress snapshot{};
+        setProgress([&](OtaProgress& p) { snapshot = p; });
+        return snapshot;
+    }
+
+    /**
+     * @brief 获取最近一次完成的镜像SHA-256（十六进制）
+     */
+    const char* getSha256() const {
+        return actual;
+    }
+
+   private:
+    FsImageUpdater() {
+        mbedtls_md_init(&sha);
+    }
+
+    FsImageUpdater(const FsImageUpdater&) = delete;
+    FsImageUpdater& operator=(const FsImageUpdater&) = delete;
+
+    /**
+     * @brief 写入任务回调：按块擦除，跳过空白扇区，写入分区并更新SHA-256
+     */
+    bool writePartition(const uint8_t* data, size_t length) {
+        size_t end = flashOffset + length;
+        if (end > partition->size) {
+            ESP_LOGE(TAG, "Image exceeds partition size");
+            return false;
+        }
+        while (end > erasedTo) {
+            size_t blockSize = std::min(FLASH_BLOCK_SIZE, partition->size - erasedTo);
+            if (isBlank(erasedTo, blockSize)) {
+                skippedBlocks++;
+            } else {
+                esp_err_t err = esp_partition_erase_range(partition, erasedTo, blockSize);
+                if (err != ESP_OK) {
+                    ESP_LOGE(TAG, "Erase failed at 0x%x: %s", erasedTo, esp_err_to_name(err));
+                    return false;
+                }
+            }
+            erasedTo += blockSize;
+        }
+
+        mbedtls_md_update(&sha, data, length);
+        for (size_t offset = 0; offset < length;) {
+            // 按扇区边界切分，全0xFF的部分已经是擦除状态，无需写入
+            size_t n = std::min(length - offset, FLASH_SECTOR_SIZE - (flashOffset + offset) % FLASH_SECTOR_SIZE);
+            if (!isErased(data + offset, n)) {
+                esp_err_t err = esp_partition_write(partition, flashOffset + offset, data + offset, n);
+                if (err != ESP_OK) {
+                    ESP_LOGE(TAG, "Write failed at 0x%x: %s", flashOffset + offset, esp_err_to_name(err));
+                    return false;
+                }
+            }
+            offset += n;
+        }
+
+        flashOffset = end;
+        setProgress([&](OtaProgress& p) { p.written += length; });
+        return true;
+    }
+
+    /**
+     * @brief 分区中的一段是否已经是擦除状态
+     */
+    bool isBlank(size_t offset, size_t length) {
+        for (size_t pos = 0; pos < length; pos += sizeof(readBuffer)) {
+            size_t n = std::min(sizeof(readBuffer), length - pos);
+            if (esp_partition_read(partition, offset + pos, readBuffer, n) != ESP_OK ||
+                !isErased(readBuffer, n)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool isErased(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] != 0xFF) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 读出需要保留的文件，不存在的文件跳过
+     * @return 是否全部读取成功
+     */
+    bool readPreserved() {
+        auto& fs = LittleFSController::getInstance();
+        preserved.clear();
+        for (const std::string& path : preservedPaths) {
+            std::string content;
+            if (!fs.exists(path.c_str())) {
+                continue;
+            }
+            if (!fs.tryReadFile(path.c_str(), content, portMAX_DELAY)) {
+                ESP_LOGE(TAG, "Failed to read %s", path.c_str());
+                preserved.clear();
+                return false;
+            }
+            preserved.put(path.c_str(), reinterpret_cast<const uint8_t*>(content.data()), content.size());
+        }
+        return true;
+    }
+
+    /**
+     * @brief 停止写入
+     */
+    void abortSession() {
+        pipeline.stop();
+        inflater.end();
+        mbedtls_md_free(&sha);
+        active = false;
+    }
+
+    /**
+     * @brief 重新挂载文件系统并写回保留的文件，失败时在进度中标记文件系统不可用
+     * @return 挂载是否成功
+     */
+    bool remount() {
+        bool mounted = LittleFSController::getInstance().remount(preserved);
+        preserved.clear();
+        setProgress([&](OtaProgress& p) { p.fsUnusable = !mounted; });
+        if (mounted) {
+            setImageWritePending(false);
+        } else {
+            ESP_LOGE(TAG, "Filesystem unusable until a valid image is uploaded, partition kept as is across reboots");
+        }
+        return mounted;
+    }
+
+    /**
+     * @brief 在NVS中记录或清除镜像写入未完成标记
+     */
+    static void setImageWritePending(bool pending) {
+        Preferences preferences;
+        if (!preferences.begin(NVS_NAMESPACE, false)) {
+            ESP_LOGE(TAG, "Failed to open NVS namespace");
+            return;
+        }
+        if (preferences.putBool(NVS_PENDING_KEY, pending) == 0) {
+            ESP_LOGE(TAG, "Failed to save image write state");
+        }
+        preferences.end();
+    }
+
+    bool fail(const char* reason) {
+        setProgress([&](OtaProgress& p) {
+            p.phase = OtaPhase::FAILED;
+            strlcpy(p.error, reason, sizeof(p.error));
+        });
+        ESP_LOGE(TAG, "Filesystem update failed: %s", reason);
+        return false;
+    }
+
+    /**
+     * @brief 在互斥锁保护下修改进度
+     */
+    template <typename Fn>
+    void setProgress(Fn&& fn) {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            fn(progress);
+            xSemaphoreGive(mutex);
+        }
+    }
+
+    const esp_partition_t* partition = nullptr;                      // 文件系统分区
+    mbedtls_md_context_t sha;                                        // SHA-256上下文
+    char expected[OtaController::SHA256_HEX_LENGTH + 1] = {};        // 期望的SHA-256
+    char actual[OtaController::SHA256_HEX_LENGTH + 1] = {};          // 实际的SHA-256
+    FlashWritePipeline pipeline;                                     // 双缓冲写入流水线
+    GzipInflater inflater;                                           // gzip解压器
+    std::vector<std::string> preservedPaths{KvStore::DEFAULT_PATH};  // 写入镜像前后保留的文件
+    FsWriteBatch preserved;                                          // 卸载前读出的保留文件
+    bool active = false;                                             // 是否有进行中的写入
+    bool formatChecked = false;                                      // 是否已检查gzip魔数
+    bool compressed = false;                                         // 是否为gzip镜像
+    size_t flashOffset = 0;                                          // 分区写入位置
+    size_t erasedTo = 0;                                             // 分区已擦除到的位置
+    size_t skippedBlocks = 0;                                        // 跳过擦除的块数
+    uint32_t startMs = 0;                                            // 开始时间
+    uint8_t readBuffer[1024];                                        // 空白检查缓冲区
+    OtaProgress progress = {};                                       // 进度
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();               // 进度互斥锁
+};
\ No newline at end of file
@@ -0,0 +1,299 @@
+/**
+ * @file GzipInflater.hpp
+ * @brief 流式gzip解压
+ * @details 使用ROM中的miniz(tinfl)解压，输入可以任意分段，输出经由固定32KB滑动窗口逐段交给回调
+ */
+
+#pragma once
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <rom/miniz.h>
+#include <cstring>
+#include <functional>
+
+/**
+ * @brief gzip流解压器
+ *
+ * - 按字节解析gzip头（支持FEXTRA/FNAME/FCOMMENT/FHCRC），之后交给tinfl解压deflate数据
+ * - 解压窗口固定为TINFL_LZ_DICT_SIZE（32KB），与镜像大小无关
+ * - 结束时以输入的最后8字节作为gzip尾部，校验CRC32和原始长度
+ */
+class GzipInflater {
+    static constexpr const char* TAG = "GzipInflater";
+
+   public:
+    // 解压输出回调，返回false时停止解压
+    using Output = std::function<bool(const uint8_t* data, size_t length)>;
+
+    /**
+     * @brief 判断数据是否以gzip魔数开头
+     */
+    static bool isGzip(const uint8_t* data, size_t length) {
+        return length >= 2 && data[0] == 0x1F && data[1] == 0x8B;
+    }
+
+    ~GzipInflater() {
+        end();
+    }
+
+    /**
+     * @brief 分配解压状态和窗口，优先使用PSRAM
+     * @return 是否成功
+     */
+    bool begin() {
+        end();
+        inflator = static_cast<tinfl_decompressor*>(allocate(sizeof(tinfl_decompressor)));
+        window = static_cast<uint8_t*>(allocate(TINFL_LZ_DICT_SIZE));
+        if (!inflator || !window) {
+            ESP_LOGE(TAG, "Failed to allocate inflate state");
+            end();
+            return false;
+        }
+
+        tinfl_init(inflator);
+        state = State::HEADER;
+        headerPos = 0;
+        nextField = 0;
+        fieldRemaining = 0;
+        memset(tail, 0, sizeof(tail));
+        windowPos = 0;
+        crc = 0;
+        outputSize = 0;
+        return true;
+    }
+
+    /**
+     * @brief 释放解压状态
+     */
+    void end() {
+        heap_caps_free(inflator);
+        heap_caps_free(window);
+        inflator = nullptr;
+        window = nullptr;
+    }
+
+    /**
+     * @brief 输入一段压缩数据
+     * @param data 数据
+     * @param length 数据长度
+     * @param output 解压输出回调
+     * @return 是否成功
+     */
+    bool feed(const uint8_t* data, size_t length, const Output& output) {
+        updateTail(data, length);
+        while (length > 0) {
+            switch (state) {
+                case State::HEADER:
+                case State::EXTRA_LENGTH:
+                case State::EXTRA:
+                case State::NAME:
+                case State::COMMENT:
+                case State::HEADER_CRC:
+                    parseHeaderByte(*data++);
+                    length--;
+                    break;
+
+                case State::BODY:
+                    if (!inflate(data, length, output)) {
+                        state = State::ERROR;
+                        return false;
+                    }
+                    break;
+
+                case State::DONE:
+                    // deflate数据之后是gzip尾部，在finish()中从输入末尾读取
+                    return true;
+
+                case State::ERROR:
+                    return false;
+            }
+        }
+        return state != State::ERROR;
+    }
+
+    /**
+     * @brief 检查数据流是否完整且校验通过
+     */
+    bool finish() const {
+        if (state != State::DONE) {
+            ESP_LOGE(TAG, "Truncated gzip stream");
+            return false;
+        }
+
+        uint32_t expectedCrc = readLe32(tail);
+        uint32_t expectedSize = readLe32(tail + 4);
+        if (expectedCrc != crc || expectedSize != static_cast<uint32_t>(outputSize)) {
+            ESP_LOGE(
+                TAG,
+                "gzip trailer mismatch, crc %08x/%08x, size %u/%u",
+                crc,
+                expectedCrc,
+                outputSize,
+                expectedSize
+            );
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 已解压的字节数
+     */
+    size_t size() const {
+        return outputSize;
+    }
+
+   private:
+    enum class State { HEADER, EXTRA_LENGTH, EXTRA, NAME, COMMENT, HEADER_CRC, BODY, DONE, ERROR };
+
+    // gzip头标志位
+    static constexpr uint8_t FLAG_HCRC = 0x02;
+    static constexpr uint8_t FLAG_EXTRA = 0x04;
+    static constexpr uint8_t FLAG_NAME = 0x08;
+    static constexpr uint8_t FLAG_COMMENT = 0x10;
+    static constexpr size_t FIXED_HEADER_SIZE = 10;
+    static constexpr size_t TRAILER_SIZE = 8;  // CRC32 + 原始长度
+
+    static void* allocate(size_t size) {
+        void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        return ptr ? ptr : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+
+    static uint32_t readLe32(const uint8_t* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    /**
+     * @brief 记录输入的最后8字节，即gzip尾部
+     * @details tinfl解码时会预读，deflate结束位置不一定与输入分段对齐，因此不从解压位置截取尾部
+     */
+    void updateTail(const uint8_t* data, size_t length) {
+        if (length >= TRAILER_SIZE) {
+            memcpy(tail, data + length - TRAILER_SIZE, TRAILER_SIZE);
+        } else {
+            memmove(tail, tail + length, TRAILER_SIZE - length);
+            memcpy(tail + TRAILER_SIZE - length, data, length);
+        }
+    }
+
+    void parseHeaderByte(uint8_t byte) {
+        switch (state) {
+            case State::HEADER:
+                header[headerPos++] = byte;
+                if (headerPos == FIXED_HEADER_SIZE) {
+                    // 压缩方法必须为deflate(8)
+                    if (header[2] != 8) {
+                        ESP_LOGE(TAG, "Unsupported compression method %u", header[2]);
+                        state = State::ERROR;
+                        return;
+                    }
+                    nextField = 0;
+                    nextHeaderField();
+                }
+                break;
+
+            case State::EXTRA_LENGTH:
+                fieldLength |= byte << (8 * (2 - fieldRemaining));
+                if (--fieldRemaining == 0) {
+                    fieldRemaining = fieldLength;
+                    state = State::EXTRA;
+                    if (fieldRemaining == 0) nextHeaderField();
+                }
+                break;
+
+            case State::EXTRA:
+            case State::HEADER_CRC:
+                if (--fieldRemaining == 0) nextHeaderField();
+                break;
+
+            case State::NAME:
+            case State::COMMENT:
+                if (byte == 0) nextHeaderField();
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /**
+     * @brief 进入下一个存在的可选头字段，可选字段按EXTRA、NAME、COMMENT、HCRC的顺序出现
+     */
+    void nextHeaderField() {
+        static constexpr struct {
+            uint8_t flag;
+            State state;
+            size_t length;  // 定长字段的长度
+        } fields[] = {
+            {FLAG_EXTRA, State::EXTRA_LENGTH, 2},
+            {FLAG_NAME, State::NAME, 0},
+            {FLAG_COMMENT, State::COMMENT, 0},
+            {FLAG_HCRC, State::HEADER_CRC, 2},
+        };
+
+        while (nextField < sizeof(fields) / sizeof(fields[0])) {
+            const auto& field = fields[nextField++];
+            if (header[3] & field.flag) {
+                state = field.state;
+                fieldRemaining = field.length;
+                fieldLength = 0;
+                return;
+            }
+        }
+        state = State::BODY;
+    }
+
+    bool inflate(const uint8_t*& data, size_t& length, const Output& output) {
+        tinfl_status status;
+        do {
+            size_t inBytes = length;
+            size_t outBytes = TINFL_LZ_DICT_SIZE - windowPos;
+            status = tinfl_decompress(
+                inflator,
+                data,
+                &inBytes,
+                window,
+                window + windowPos,
+                &outBytes,
+                TINFL_FLAG_HAS_MORE_INPUT
+            );
+            data += inBytes;
+            length -= inBytes;
+
+            if (outBytes > 0) {
+                crc = esp_rom_crc32_le(crc, window + windowPos, outBytes);
+                outputSize += outBytes;
+                if (!output(window + windowPos, outBytes)) {
+                    return false;
+                }
+                windowPos = (windowPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+            }
+
+            if (status < TINFL_STATUS_DONE) {
+                ESP_LOGE(TAG, "Inflate failed: %d", status);
+                return false;
+            }
+        } while (status == TINFL_STATUS_HAS_MORE_OUTPUT ||
+                 (status == TINFL_STATUS_NEEDS_MORE_INPUT && length > 0));
+
+        if (status == TINFL_STATUS_DONE) {
+            state = State::DONE;
+        }
+        return true;
+    }
+
+    tinfl_decompressor* inflator = nullptr;
+    uint8_t* window = nullptr;          // 32KB解压窗口
+    State state = State::HEADER;
+    uint8_t header[FIXED_HEADER_SIZE];  // gzip固定头
+    uint8_t tail[TRAILER_SIZE] = {};    // 输入的最后8字节
+    size_t headerPos = 0;               // 固定头已接收字节数
+    size_t nextField = 0;               // 下一个待检查的可选头字段
+    size_t fieldRemaining = 0;          // 当前头字段剩余字节数
+    size_t fieldLength = 0;             // FEXTRA长度
+    size_t windowPos = 0;               // 窗口写入位置
+    uint32_t crc = 0;                   // 解压数据的CRC32
+    size_t outputSize = 0;              // 解压数据总长度
+};
\ No newline at end of file
@@ -1,10 +1,75 @@
+#pragma once
+
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <esp_app_format.h>
+#include <esp_partition.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/stream_buffer.h>
+#include <freertos/task.h>
+#include <mbedtls/md.h>
+#include <atomic>
+#include "DeltaPatcher.hpp"
+#include "FlashWritePipeline.hpp"
+#include "GzipInflater.hpp"
+#include "OtaResumeStore.hpp"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
 
+/**
+ * @brief OTA升级阶段
+ */
+enum class OtaPhase {
+    IDLE,       // 空闲
+    RECEIVING,  // 正在接收并写入固件
+    DONE,       // 写入并校验完成，等待重启
+    FAILED      // 升级失败
+};
+
+/**
+ * @brief OTA升级进度
+ */
+struct OtaProgress {
+    OtaPhase phase;      // 当前阶段
+    bool compressed;     // 上传的是否为gzip压缩镜像
+    bool delta;          // 上传的是否为差分补丁
+    size_t received;     // 已接收的上传字节数
+    size_t written;      // 已写入flash的固件字节数
+    size_t total;        // 上传总大小，0表示未知
+    size_t resumed;      // 断点续传时跳过的已写入字节数
+    uint32_t elapsedMs;  // 从开始到现在（或到完成）的时间
+    float kbps;          // 平均固件写入速度（KB/s）
+    char error[48];      // 失败原因
+    bool fsUnusable;     // 文件系统镜像升级失败后无法重新挂载，文件系统保持卸载
+};
+
+/**
+ * @brief OTA升级控制器
+ *
+ * 数据流：
+ * - 未压缩镜像：上传数据 → 双缓冲流水线 → 写入任务（esp_ota_write + SHA-256）
+ * - gzip镜像：上传数据 → 流缓冲区 → 解压任务（32KB窗口） → 双缓冲流水线 → 写入任务
+ * - 差分补丁：在上述数据流进入流水线之前，先以正在运行的分区为旧镜像应用补丁
+ * - 拉取升级：HTTP下载任务 → 双缓冲流水线 → 写入任务（按扇区擦写分区，定期在NVS中记录断点）
+ *
+ * 网络接收、解压和flash擦写分别在不同任务中进行，互相重叠。
+ * SHA-256始终针对写入flash的固件本身计算，与是否压缩、是否为差分补丁无关。
+ */
 class OtaController {
     static constexpr const char* TAG = "OtaController";
 
    public:
+    static constexpr size_t SHA256_HEX_LENGTH = 64;
+    static constexpr size_t INPUT_BUFFER_SIZE = 8 * 1024;  // 压缩数据输入缓冲区大小
+    static constexpr size_t INFLATE_CHUNK_SIZE = 1024;     // 解压任务单次读取的输入大小
+    static constexpr uint32_t INFLATE_STACK_SIZE = 6144;   // 解压任务栈大小
+    static constexpr size_t FLASH_SECTOR_SIZE = 4096;
+    static constexpr size_t PULL_READ_SIZE = 2048;                  // 下载任务单次读取大小
+    static constexpr size_t PULL_CHECKPOINT_INTERVAL = 64 * 1024;  // 断点保存间隔
+    static constexpr uint32_t PULL_STACK_SIZE = 8192;               // 下载任务栈大小
+    static constexpr uint16_t PULL_TIMEOUT_MS = 10000;              // 连接和无数据超时
+
     static OtaController& getInstance() {
         static OtaController instance;
         return instance;
@@ -59,9 +124,799 @@ class OtaController {
         }
     }
 
+    /**
+     * @brief 开始一次升级，写入目标为下一个OTA分区
+     * @details 分区按写入进度逐扇区擦除，不在开始时整块擦除6MB分区；
+     *          是否为gzip镜像、是否为差分补丁由数据的魔数自动判断
+     * @param uploadSize 上传数据大小，0表示未知
+     * @param expectedSha256 期望的固件（解压后）SHA-256，64位十六进制，nullptr表示不校验
+     * @return 是否成功
+     */
+    bool begin(size_t uploadSize = 0, const char* expectedSha256 = nullptr) {
+        if (session == Session::PULL) {
+            ESP_LOGW(TAG, "Pull update in progress");
+            return false;
+        }
+        if (session != Session::NONE) {
+            ESP_LOGW(TAG, "Aborting unfinished update");
+            abort();
+        }
+
+        inflateFailed = false;
+        formatChecked = false;
+        patching = false;
+        if (!prepare(uploadSize, expectedSha256)) {
+            return false;
+        }
+
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+        esp_err_t err = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+#else
+        esp_err_t err = esp_ota_begin(partition, OTA_SIZE_UNKNOWN, &handle);
+#endif
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
+            return fail("Begin failed");
+        }
+
+        mbedtls_md_init(&sha);
+        mbedtls_md_setup(&sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&sha);
+
+        if (!pipeline.start([this](const uint8_t* data, size_t length) {
+                return writeFlash(data, length);
+            })) {
+            abortOta();
+            return fail("Out of memory");
+        }
+
+        startMs = millis();
+        session = Session::PENDING;
+        ESP_LOGI(TAG, "Update started, partition: %s, upload size: %u", partition->label, uploadSize);
+        return true;
+    }
+
+    /**
+     * @brief 写入一段上传数据，原始镜像直接进入写入流水线，gzip镜像交给解压任务
+     * @param data 数据
+     * @param length 数据长度
+     * @return 是否成功
+     */
+    bool write(const uint8_t* data, size_t length) {
+        if (session == Session::NONE || session == Session::PULL) {
+            return false;
+        }
+
+        if (session == Session::PENDING && !selectMode(data, length)) {
+            return false;
+        }
+
+        setProgress([&](OtaProgress& p) { p.received += length; });
+
+        bool ok = session == Session::GZIP ? sendInput(data, length) : emit(data, length);
+        if (!ok) {
+            const char* reason = streamError();
+            abortSession();
+            return fail(reason);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 结束升级：等待解压和写入完成，校验镜像和SHA-256，并设置为下次启动分区
+     * @return 是否成功
+     */
+    bool finish() {
+        if (session == Session::NONE || session == Session::PULL) {
+            return false;
+        }
+
+        bool compressed = session == Session::GZIP;
+        if (compressed) {
+            inputDone = true;
+            waitInflate();
+            if (inflateFailed || !inflater.finish()) {
+                const char* reason = streamError();
+                abortSession();
+                return fail(reason);
+            }
+        }
+
+        bool delta = patching;
+        if (delta && !patcher.finish()) {
+            abortSession();
+            return fail("Incomplete patch");
+        }
+
+        if (!pipeline.finish()) {
+            abortSession();
+            return fail("Write failed");
+        }
+        releaseInflate();
+        session = Session::NONE;
+
+        OtaProgress result = getProgress();
+        if (result.total && result.received != result.total) {
+            abortOta();
+            return fail("Incomplete image");
+        }
+
+        if (!verifyDigest()) {
+            abortOta();
+            return fail("SHA-256 mismatch");
+        }
+
+        esp_err_t err = esp_ota_end(handle);
+        handle = 0;
+        if (err == ESP_OK) {
+            err = esp_ota_set_boot_partition(partition);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to finalize update: %s", esp_err_to_name(err));
+            return fail(err == ESP_ERR_OTA_VALIDATE_FAILED ? "Invalid image" : "Finalize failed");
+        }
+
+        setProgress([&](OtaProgress& p) {
+            updateRate(p);
+            p.phase = OtaPhase::DONE;
+            result = p;
+        });
+        ESP_LOGI(
+            TAG,
+            "Update written: %u bytes in %u ms (%.1f KB/s), sha256: %s",
+            result.written,
+            result.elapsedMs,
+            result.kbps,
+            actual
+        );
+        if (compressed || delta) {
+            // 不可压缩的数据或较大的补丁可能比写入量还大，节省量为负
+            int32_t saved = static_cast<int32_t>(result.written) - static_cast<int32_t>(result.received);
+            ESP_LOGI(
+                TAG,
+                "%s upload: %u bytes, saved %d bytes (%.0f%%)",
+                delta ? "Delta" : "Compressed",
+                result.received,
+                saved,
+                result.written ? 100.0f * saved / result.written : 0.0f
+            );
+        }
+        return true;
+    }
+
+    /**
+     * @brief 放弃当前升级
+     * @param reason 原因
+     */
+    void abort(const char* reason = "Aborted") {
+        if (session == Session::NONE) {
+            return;
+        }
+        if (session == Session::PULL) {
+            // 下载任务自行停止并保留断点
+            pullCancelled = true;
+            return;
+        }
+        abortSession();
+        fail(reason);
+    }
+
+    /**
+     * @brief 从HTTP服务器拉取固件，在后台任务中下载并写入下一个OTA分区
+     * @details 服务器需要支持Range请求。下载中断后用相同的地址和SHA-256再次调用，
+     *          从NVS中记录的最后写入扇区继续；服务器返回的ETag变化时重新下载。
+     *          拉取的固件不能是gzip压缩或差分补丁
+     * @param url 固件地址（http://）
+     * @param expectedSha256 期望的固件SHA-256，nullptr表示不校验
+     * @param restart 完成后是否自动重启到新固件
+     * @return 是否已开始下载
+     */
+    bool pull(const char* url, const char* expectedSha256 = nullptr, bool restart = true) {
+        if (session != Session::NONE) {
+            ESP_LOGW(TAG, "Update already in progress");
+            return false;
+        }
+        if (url == nullptr || strlen(url) >= sizeof(pullUrl)) {
+            return fail("Invalid URL");
+        }
+        if (!prepare(0, expectedSha256)) {
+            return false;
+        }
+
+        strlcpy(pullUrl, url, sizeof(pullUrl));
+        pullRestart = restart;
+        pullCancelled = false;
+        startMs = millis();
+        session = Session::PULL;
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& ota = *static_cast<OtaController*>(param);
+                ota.pullTask();
+            },
+            "ota_pull",
+            PULL_STACK_SIZE,
+            this,
+            2,
+            nullptr
+        );
+        if (xReturned != pdPASS) {
+            session = Session::NONE;
+            return fail("Failed to create pull task");
+        }
+        return true;
+    }
+
+    /**
+     * @brief 获取升级进度（可在任意任务中调用）
+     */
+    OtaProgress getProgress() {
+        OtaProgress snapshot{};
+        setProgress([&](OtaProgress& p) {
+            if (p.phase == OtaPhase::RECEIVING) {
+                updateRate(p);
+            }
+            snapshot = p;
+        });
+        return snapshot;
+    }
+
+    /**
+     * @brief 获取最近一次完成的升级的SHA-256（十六进制）
+     */
+    const char* getSha256() const {
+        return actual;
+    }
+
+    /**
+     * @brief 延时重启，用于在响应发送完成后切换到新固件
+     * @param delayMs 延时时间
+     */
+    void scheduleRestart(uint32_t delayMs = 1000) {
+        xTaskCreate(
+            [](void* param) {
+                vTaskDelay(pdMS_TO_TICKS(reinterpret_cast<uintptr_t>(param)));
+                ESP_LOGI(TAG, "Restarting into new firmware");
+                esp_restart();
+            },
+            "ota_restart",
+            2048,
+            reinterpret_cast<void*>(static_cast<uintptr_t>(delayMs)),
+            1,
+            nullptr
+        );
+    }
+
+    /**
+     * @brief 获取阶段名称
+     */
+    static const char* phaseToString(OtaPhase phase) {
+        switch (phase) {
+            case OtaPhase::IDLE:
+                return "idle";
+            case OtaPhase::RECEIVING:
+                return "receiving";
+            case OtaPhase::DONE:
+                return "done";
+            case OtaPhase::FAILED:
+                return "failed";
+        }
+        return "unknown";
+    }
+
    private:
-    OtaController() {}
+    /**
+     * @brief 当前升级会话的数据格式
+     */
+    enum class Session {
+        NONE,     // 没有进行中的升级
+        PENDING,  // 已开始，尚未收到数据
+        RAW,      // 未压缩镜像
+        GZIP,     // gzip压缩镜像
+        PULL      // 后台拉取
+    };
+
+    OtaController() {
+        mbedtls_md_init(&sha);
+    }
 
     OtaController(const OtaController&) = delete;
     OtaController& operator=(const OtaController&) = delete;
+
+    /**
+     * @brief 重置进度和校验值，选择目标分区
+     * @param total 数据总大小，0表示未知
+     * @param expectedSha256 期望的SHA-256
+     */
+    bool prepare(size_t total, const char* expectedSha256) {
+        setProgress([&](OtaProgress& p) {
+            p = {};
+            p.phase = OtaPhase::RECEIVING;
+            p.total = total;
+        });
+        actual[0] = '\0';
+        expected[0] = '\0';
+        if (expectedSha256) {
+            if (strlen(expectedSha256) != SHA256_HEX_LENGTH) {
+                return fail("Invalid SHA-256");
+            }
+            strlcpy(expected, expectedSha256, sizeof(expected));
+        }
+
+        partition = esp_ota_get_next_update_partition(nullptr);
+        if (partition == nullptr) {
+            return fail("No update partition");
+        }
+        if (total > partition->size) {
+            return fail("Image too large");
+        }
+        return true;
+    }
+
+    /**
+     * @brief 结束SHA-256计算并与期望值比较
+     */
+    bool verifyDigest() {
+        uint8_t digest[32];
+        mbedtls_md_finish(&sha, digest);
+        mbedtls_md_free(&sha);
+        for (size_t i = 0; i < sizeof(digest); i++) {
+            snprintf(actual + i * 2, 3, "%02x", digest[i]);
+        }
+
+        if (expected[0] && strcasecmp(expected, actual) != 0) {
+            ESP_LOGE(TAG, "SHA-256 mismatch, expected %s, got %s", expected, actual);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 根据第一段数据判断镜像格式，gzip镜像启动解压任务
+     */
+    bool selectMode(const uint8_t* data, size_t length) {
+        if (!GzipInflater::isGzip(data, length)) {
+            session = Session::RAW;
+            return true;
+        }
+
+        input = xStreamBufferCreate(INPUT_BUFFER_SIZE, 1);
+        inflateDone = xSemaphoreCreateBinary();
+        if (!input || !inflateDone || !inflater.begin()) {
+            abortSession();
+            return fail("Out of memory");
+        }
+
+        inputDone = false;
+        inflateFailed = false;
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& ota = *static_cast<OtaController*>(param);
+                ota.inflateTask();
+            },
+            "ota_inflate",
+            INFLATE_STACK_SIZE,
+            this,
+            2,
+            nullptr
+        );
+        if (xReturned != pdPASS) {
+            abortSession();
+            return fail("Failed to create inflate task");
+        }
+
+        inflateRunning = true;
+        session = Session::GZIP;
+        setProgress([](OtaProgress& p) { p.compressed = true; });
+        return true;
+    }
+
+    /**
+     * @brief 把压缩数据送入解压任务，缓冲区满时等待（解压失败时立即返回）
+     */
+    bool sendInput(const uint8_t* data, size_t length) {
+        while (length > 0) {
+            if (inflateFailed) {
+                return false;
+            }
+            size_t sent = xStreamBufferSend(input, data, length, pdMS_TO_TICKS(100));
+            data += sent;
+            length -= sent;
+        }
+        return !inflateFailed;
+    }
+
+    /**
+     * @brief 把固件数据（或补丁数据）交给流水线，第一段数据以补丁魔数开头时启用差分升级
+     * @details 原始上传时在接收任务中调用，gzip上传时在解压任务中调用
+     */
+    bool emit(const uint8_t* data, size_t length) {
+        if (!formatChecked) {
+            formatChecked = true;
+            if (DeltaPatcher::isPatch(data, length)) {
+                patcher.begin(esp_ota_get_running_partition());
+                patching = true;
+                setProgress([](OtaProgress& p) { p.delta = true; });
+            }
+        }
+
+        if (!patching) {
+            return pipeline.write(data, length);
+        }
+        return patcher.feed(data, length, [this](const uint8_t* target, size_t targetLength) {
+            return pipeline.write(target, targetLength);
+        });
+    }
+
+    /**
+     * @brief 数据流失败的原因
+     */
+    const char* streamError() const {
+        if (patching && patcher.hasFailed()) {
+            return "Patch failed";
+        }
+        return inflateFailed ? "Decompression failed" : "Write failed";
+    }
+
+    /**
+     * @brief 解压任务：从输入缓冲区读取压缩数据，解压结果写入流水线
+     */
+    void inflateTask() {
+        uint8_t chunk[INFLATE_CHUNK_SIZE];
+        auto output = [this](const uint8_t* data, size_t length) {
+            return !inflateFailed && emit(data, length);
+        };
+
+        while (!inflateFailed) {
+            size_t n = xStreamBufferReceive(input, chunk, sizeof(chunk), pdMS_TO_TICKS(100));
+            if (n > 0) {
+                if (!inflater.feed(chunk, n, output)) {
+                    inflateFailed = true;
+                }
+            } else if (inputDone && xStreamBufferIsEmpty(input)) {
+                break;
+            }
+        }
+
+        // 解压结果已全部交给流水线，提交最后一个未满的缓冲区
+        if (!inflateFailed) {
+            pipeline.flush();
+        }
+        xSemaphoreGive(inflateDone);
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief 写入任务回调：写入flash并更新SHA-256
+     */
+    bool writeFlash(const uint8_t* data, size_t length) {
+        esp_err_t err = esp_ota_write(handle, data, length);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
+            return false;
+        }
+
+        mbedtls_md_update(&sha, data, length);
+        setProgress([&](OtaProgress& p) { p.written += length; });
+        return true;
+    }
+
+    /**
+     * @brief 下载任务
+     */
+    void pullTask() {
+        bool ok = download();
+        session = Session::NONE;
+        if (ok && pullRestart) {
+            scheduleRestart();
+        }
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief 下载固件并写入分区，成功后设置为下次启动分区
+     */
+    bool download() {
+        OtaResumeState state{};
+        bool resumable = resumeStore.load(state) && state.offset > 0 &&
+                         strcmp(state.url, pullUrl) == 0 && strcmp(state.sha256, expected) == 0 &&
+                         strcmp(state.partition, partition->label) == 0;
+        if (!resumable) {
+            state = {};
+            strlcpy(state.url, pullUrl, sizeof(state.url));
+            strlcpy(state.sha256, expected, sizeof(state.sha256));
+            strlcpy(state.partition, partition->label, sizeof(state.partition));
+        }
+
+        HTTPClient http;
+        const char* headers[] = {"ETag", "Content-Range"};
+        http.setConnectTimeout(PULL_TIMEOUT_MS);
+        http.setTimeout(PULL_TIMEOUT_MS);
+        if (!http.begin(pullUrl)) {
+            return fail("Invalid URL");
+        }
+        http.collectHeaders(headers, 2);
+        if (resumable) {
+            char range[32];
+            snprintf(range, sizeof(range), "bytes=%u-", state.offset);
+            http.addHeader("Range", range);
+            if (state.etag[0]) {
+                // 服务器上的固件变化时返回200和完整内容
+                http.addHeader("If-Range", state.etag);
+            }
+        }
+
+        int code = http.GET();
+        size_t offset = 0;
+        if (code == HTTP_CODE_PARTIAL_CONTENT && resumable) {
+            unsigned start = 0;
+            unsigned total = 0;
+            if (sscanf(http.header("Content-Range").c_str(), "bytes %u-%*u/%u", &start, &total) != 2 ||
+                start != state.offset || total != state.total) {
+                http.end();
+                resumeStore.clear();
+                return fail("Unexpected Content-Range");
+            }
+            offset = state.offset;
+        } else if (code == HTTP_CODE_OK && http.getSize() > 0) {
+            state.total = http.getSize();
+            state.offset = 0;
+            strlcpy(state.etag, http.header("ETag").c_str(), sizeof(state.etag));
+        } else {
+            ESP_LOGE(TAG, "Unexpected HTTP response: %d", code);
+            http.end();
+            return fail("Download failed");
+        }
+
+        if (state.total > partition->size) {
+            http.end();
+            resumeStore.clear();
+            return fail("Image too large");
+        }
+        setProgress([&](OtaProgress& p) {
+            p.total = state.total;
+            p.received = p.written = p.resumed = offset;
+        });
+
+        // 续传时重新计算已写入部分的SHA-256
+        mbedtls_md_init(&sha);
+        mbedtls_md_setup(&sha, mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), 0);
+        mbedtls_md_starts(&sha);
+        if (offset > 0 && !hashPartition(offset)) {
+            http.end();
+            mbedtls_md_free(&sha);
+            return fail("Flash read failed");
+        }
+
+        flashOffset = erasedTo = offset;
+        resumeState = state;
+        resumeStore.save(resumeState);
+        if (!pipeline.start([this](const uint8_t* data, size_t length) {
+                return writePartition(data, length);
+            })) {
+            http.end();
+            mbedtls_md_free(&sha);
+            return fail("Out of memory");
+        }
+
+        if (offset > 0) {
+            ESP_LOGI(TAG, "Resuming download at %u of %u bytes", offset, state.total);
+        } else {
+            ESP_LOGI(TAG, "Downloading %u bytes to %s", state.total, partition->label);
+        }
+
+        WiFiClient* stream = http.getStreamPtr();
+        uint8_t buffer[PULL_READ_SIZE];
+        uint32_t lastDataMs = millis();
+        size_t received = offset;
+        const char* error = nullptr;
+        bool interrupted = false;
+        while (received < state.total && !pullCancelled) {
+            size_t available = stream->available();
+            if (available == 0) {
+                if (!http.connected() || millis() - lastDataMs > PULL_TIMEOUT_MS) {
+                    interrupted = true;
+                    break;
+                }
+                vTaskDelay(pdMS_TO_TICKS(5));
+                continue;
+            }
+
+            int n = stream->read(buffer, std::min({available, sizeof(buffer), state.total - received}));
+            if (n <= 0) {
+                continue;
+            }
+            if (received == 0 && buffer[0] != ESP_IMAGE_HEADER_MAGIC) {
+                error = "Invalid image";
+                break;
+            }
+            if (!pipeline.write(buffer, n)) {
+                break;
+            }
+            received += n;
+            lastDataMs = millis();
+            setProgress([&](OtaProgress& p) { p.received = received; });
+        }
+        http.end();
+
+        // 已收到的数据全部写入，断点随之推进
+        if (!pipeline.finish()) {
+            error = "Write failed";
+        }
+        if (!error && (interrupted || pullCancelled)) {
+            mbedtls_md_free(&sha);
+            ESP_LOGI(TAG, "Download stopped at %u bytes, pull again to resume", resumeState.offset);
+            return fail(pullCancelled ? "Aborted" : "Download interrupted");
+        }
+        if (error) {
+            mbedtls_md_free(&sha);
+            resumeStore.clear();
+            return fail(error);
+        }
+
+        resumeStore.clear();
+        if (!verifyDigest()) {
+            return fail("SHA-256 mismatch");
+        }
+        // 设置启动分区时会校验镜像
+        esp_err_t err = esp_ota_set_boot_partition(partition);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to finalize update: %s", esp_err_to_name(err));
+            return fail("Invalid image");
+        }
+
+        OtaProgress result;
+        setProgress([&](OtaProgress& p) {
+            updateRate(p);
+            p.phase = OtaPhase::DONE;
+            result = p;
+        });
+        ESP_LOGI(
+            TAG,
+            "Download complete: %u bytes (%u resumed) in %u ms (%.1f KB/s), sha256: %s",
+            result.written,
+            result.resumed,
+            result.elapsedMs,
+            result.kbps,
+            actual
+        );
+        return true;
+    }
+
+    /**
+     * @brief 把分区中已写入的部分计入SHA-256
+     */
+    bool hashPartition(size_t length) {
+        uint8_t buffer[1024];
+        for (size_t offset = 0; offset < length; offset += sizeof(buffer)) {
+            size_t n = std::min(sizeof(buffer), length - offset);
+            if (esp_partition_read(partition, offset, buffer, n) != ESP_OK) {
+                return false;
+            }
+            mbedtls_md_update(&sha, buffer, n);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 写入任务回调（拉取升级）：按扇区擦除并写入分区，更新SHA-256和断点
+     */
+    bool writePartition(const uint8_t* data, size_t length) {
+        size_t end = flashOffset + length;
+        if (end > erasedTo) {
+            size_t eraseEnd = (end + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+            esp_err_t err = esp_partition_erase_range(partition, erasedTo, eraseEnd - erasedTo);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Erase failed at 0x%x: %s", erasedTo, esp_err_to_name(err));
+                return false;
+            }
+            erasedTo = eraseEnd;
+        }
+
+        esp_err_t err = esp_partition_write(partition, flashOffset, data, length);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Write failed at 0x%x: %s", flashOffset, esp_err_to_name(err));
+            return false;
+        }
+        mbedtls_md_update(&sha, data, length);
+        flashOffset = end;
+        setProgress([&](OtaProgress& p) { p.written += length; });
+
+        // 只记录扇区对齐的位置，续传时从该扇区开始重新擦除写入
+        if (flashOffset % FLASH_SECTOR_SIZE == 0 &&
+            flashOffset - resumeState.offset >= PULL_CHECKPOINT_INTERVAL) {
+            resumeState.offset = flashOffset;
+            resumeStore.save(resumeState);
+        }
+        return true;
+    }
+
+    /**
+     * @brief 停止解压和写入任务，并放弃OTA句柄
+     */
+    void abortSession() {
+        inflateFailed = true;
+        waitInflate();
+        pipeline.stop();
+        releaseInflate();
+        abortOta();
+        session = Session::NONE;
+    }
+
+    /**
+     * @brief 等待解压任务退出
+     */
+    void waitInflate() {
+        if (inflateRunning) {
+            xSemaphoreTake(inflateDone, portMAX_DELAY);
+            inflateRunning = false;
+        }
+    }
+
+    void releaseInflate() {
+        inflater.end();
+        if (input) vStreamBufferDelete(input);
+        if (inflateDone) vSemaphoreDelete(inflateDone);
+        input = nullptr;
+        inflateDone = nullptr;
+    }
+
+    void abortOta() {
+        if (handle) {
+            esp_ota_abort(handle);
+            handle = 0;
+        }
+        mbedtls_md_free(&sha);
+    }
+
+    bool fail(const char* reason) {
+        setProgress([&](OtaProgress& p) {
+            p.phase = OtaPhase::FAILED;
+            strlcpy(p.error, reason, sizeof(p.error));
+        });
+        ESP_LOGE(TAG, "Update failed: %s", reason);
+        return false;
+    }
+
+    /**
+     * @brief 在互斥锁保护下修改进度
+     */
+    template <typename Fn>
+    void setProgress(Fn&& fn) {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            fn(progress);
+            xSemaphoreGive(mutex);
+        }
+    }
+
+    void updateRate(OtaProgress& p) {
+        p.elapsedMs = millis() - startMs;
+        p.kbps = p.elapsedMs ? ((p.written - p.resumed) / 1024.0f) / (p.elapsedMs / 1000.0f) : 0;
+    }
+
+    const esp_partition_t* partition = nullptr;         // 目标分区
+    esp_ota_handle_t handle = 0;                        // OTA句柄
+    mbedtls_md_context_t sha;                           // SHA-256上下文
+    char expected[SHA256_HEX_LENGTH + 1] = {};          // 期望的SHA-256
+    char actual[SHA256_HEX_LENGTH + 1] = {};            // 实际的SHA-256
+    uint32_t startMs = 0;                               // 开始时间
+    std::atomic<Session> session{Session::NONE};        // 当前会话
+    FlashWritePipeline pipeline;                        // 双缓冲写入流水线
+    GzipInflater inflater;                              // gzip解压器
+    DeltaPatcher patcher;                               // 差分补丁应用器
+    bool formatChecked = false;                         // 是否已检查补丁魔数
+    bool patching = false;                              // 当前升级是否为差分补丁
+    char pullUrl[sizeof(OtaResumeState::url)] = {};     // 拉取地址
+    bool pullRestart = true;                            // 拉取完成后是否重启
+    std::atomic<bool> pullCancelled{false};             // 拉取被取消
+    OtaResumeStore resumeStore;                         // 断点存储
+    OtaResumeState resumeState = {};                    // 当前拉取的断点
+    size_t flashOffset = 0;                             // 分区写入位置
+    size_t erasedTo = 0;                                // 分区已擦除到的位置
+    StreamBufferHandle_t input = nullptr;               // 压缩数据输入缓冲区
+    SemaphoreHandle_t inflateDone = nullptr;            // 解压任务退出信号
+    bool inflateRunning = false;                        // 解压任务是否在运行
+    std::atomic<bool> inputDone{false};                 // 上传数据已全部送入
+    std::atomic<bool> inflateFailed{false};             // 解压失败或被取消
+    OtaProgress progress = {};                          // 升级进度
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 进度互斥锁
 };
\ No newline at end of file
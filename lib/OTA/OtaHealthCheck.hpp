@@ -0,0 +1,216 @@
+/**
+ * @file OtaHealthCheck.hpp
+ * @brief 升级后自检与自动回滚
+ * @details 新固件首次启动时处于待验证状态，全部自检通过后才确认有效，否则回滚到上一个固件
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <esp_ota_ops.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief 升级后自检
+ *
+ * - 只在运行分区为待验证状态（ESP_OTA_IMG_PENDING_VERIFY）时运行，正常启动不做任何事
+ * - 自检在独立任务中轮询，不阻塞setup()；每项检查有各自的时间预算，通过后不再检查
+ * - 全部通过立即确认固件有效，任一检查超出预算则标记无效并重启回滚
+ *
+ * 需要在main.cpp中定义 verifyRollbackLater() 返回true，阻止Arduino在启动时自动确认固件。
+ *
+ * @note addCheck()必须在start()之前调用
+ */
+class OtaHealthCheck {
+    static constexpr const char* TAG = "OtaHealthCheck";
+
+   public:
+    // 检查函数，必须快速返回，未就绪时返回false，稍后会再次调用
+    using Check = std::function<bool()>;
+
+    static constexpr size_t MAX_CHECKS = 8;
+    static constexpr uint32_t DEFAULT_BUDGET_MS = 10000;
+
+    /**
+     * @brief 自检状态
+     */
+    enum class Status {
+        IDLE,     // 未开始
+        SKIPPED,  // 固件不在待验证状态，无需自检
+        RUNNING,  // 正在自检
+        PASSED,   // 已确认固件有效
+        FAILED    // 自检失败，正在回滚
+    };
+
+    static OtaHealthCheck& getInstance() {
+        static OtaHealthCheck instance;
+        return instance;
+    }
+
+    /**
+     * @brief 添加检查项
+     * @param name 名称，用于日志
+     * @param check 检查函数
+     * @param budgetMs 从自检开始起允许的最长时间
+     * @return 是否添加成功
+     */
+    bool addCheck(const char* name, Check check, uint32_t budgetMs = DEFAULT_BUDGET_MS) {
+        if (status == Status::RUNNING) {
+            ESP_LOGE(TAG, "Cannot add check while running");
+            return false;
+        }
+        if (checkCount >= MAX_CHECKS) {
+            ESP_LOGE(TAG, "Too many health checks");
+            return false;
+        }
+        checks[checkCount++] = {name, std::move(check), budgetMs, false};
+        return true;
+    }
+
+    /**
+     * @brief 空闲内部RAM不低于下限
+     * @param minFreeBytes 下限
+     */
+    static Check heapFloor(size_t minFreeBytes) {
+        return [minFreeBytes]() {
+            return heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >= minFreeBytes;
+        };
+    }
+
+    /**
+     * @brief 开始自检
+     * @param pollIntervalMs 轮询间隔
+     * @return 是否启动了自检任务（固件不需要验证时返回false）
+     */
+    bool start(uint32_t pollIntervalMs = 200) {
+        if (status == Status::RUNNING) {
+            return true;
+        }
+
+        esp_ota_img_states_t state;
+        const esp_partition_t* running = esp_ota_get_running_partition();
+        if (esp_ota_get_state_partition(running, &state) != ESP_OK ||
+            state != ESP_OTA_IMG_PENDING_VERIFY) {
+            ESP_LOGD(TAG, "Firmware not pending verification, skipping health checks");
+            status = Status::SKIPPED;
+            return false;
+        }
+
+        interval = pollIntervalMs;
+        status = Status::RUNNING;
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& health = *static_cast<OtaHealthCheck*>(param);
+                health.checkTask();
+            },
+            "ota_health",
+            4096,
+            this,
+            1,
+            nullptr
+        );
+        if (xReturned != pdPASS) {
+            // 无法自检时不能确认固件，回滚比带着未验证的固件运行更安全
+            ESP_LOGE(TAG, "Failed to create health check task");
+            rollback();
+            return false;
+        }
+
+        ESP_LOGI(TAG, "New firmware pending verification, running %u checks", checkCount);
+        return true;
+    }
+
+    /**
+     * @brief 获取自检状态
+     */
+    Status getStatus() const {
+        return status;
+    }
+
+    /**
+     * @brief 获取状态名称
+     */
+    static const char* statusToString(Status status) {
+        switch (status) {
+            case Status::IDLE:
+                return "idle";
+            case Status::SKIPPED:
+                return "skipped";
+            case Status::RUNNING:
+                return "running";
+            case Status::PASSED:
+                return "passed";
+            case Status::FAILED:
+                return "failed";
+        }
+        return "unknown";
+    }
+
+   private:
+    struct Entry {
+        const char* name;   // 名称
+        Check check;        // 检查函数
+        uint32_t budgetMs;  // 时间预算
+        bool passed;        // 是否已通过
+    };
+
+    OtaHealthCheck() = default;
+    OtaHealthCheck(const OtaHealthCheck&) = delete;
+    OtaHealthCheck& operator=(const OtaHealthCheck&) = delete;
+
+    void checkTask() {
+        uint32_t startMs = millis();
+        size_t remaining = checkCount;
+
+        while (remaining > 0) {
+            uint32_t elapsed = millis() - startMs;
+            for (size_t i = 0; i < checkCount; i++) {
+                Entry& entry = checks[i];
+                if (entry.passed) continue;
+
+                if (entry.check()) {
+                    entry.passed = true;
+                    remaining--;
+                    ESP_LOGI(TAG, "Check '%s' passed after %u ms", entry.name, elapsed);
+                } else if (elapsed >= entry.budgetMs) {
+                    ESP_LOGE(TAG, "Check '%s' failed within %u ms budget", entry.name, entry.budgetMs);
+                    rollback();
+                    vTaskDelete(nullptr);
+                    return;
+                }
+            }
+            if (remaining > 0) {
+                vTaskDelay(pdMS_TO_TICKS(interval));
+            }
+        }
+
+        esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+        if (err == ESP_OK) {
+            status = Status::PASSED;
+            ESP_LOGI(TAG, "All checks passed in %u ms, firmware marked valid", millis() - startMs);
+        } else {
+            status = Status::FAILED;
+            ESP_LOGE(TAG, "Failed to mark firmware valid: %s", esp_err_to_name(err));
+        }
+        vTaskDelete(nullptr);
+    }
+
+    /**
+     * @brief 标记当前固件无效并重启到上一个固件，成功时不返回
+     */
+    void rollback() {
+        status = Status::FAILED;
+        esp_err_t err = esp_ota_mark_app_invalid_rollback_and_reboot();
+        ESP_LOGE(TAG, "Rollback failed: %s", esp_err_to_name(err));
+    }
+
+    Entry checks[MAX_CHECKS];                  // 检查项
+    size_t checkCount = 0;                     // 检查项数量
+    uint32_t interval = 200;                   // 轮询间隔
+    std::atomic<Status> status{Status::IDLE};  // 自检状态
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+/**
+ * @file OtaResumeStore.hpp
+ * @brief 拉取升级的断点信息
+ * @details 保存在NVS中，下载中断（断网、掉电）后可以从最后写入的扇区继续
+ */
+
+#pragma once
+
+#include <Preferences.h>
+#include <esp_log.h>
+#include <cstring>
+
+/**
+ * @brief 拉取升级断点
+ */
+struct OtaResumeState {
+    char url[256];       // 固件地址
+    char etag[64];       // 服务器返回的ETag，用于确认固件未变化
+    char sha256[65];     // 期望的SHA-256，空字符串表示不校验
+    char partition[17];  // 目标分区名称
+    uint32_t total;      // 固件大小
+    uint32_t offset;     // 已写入flash的字节数（扇区对齐）
+};
+
+/**
+ * @brief 断点存储，整个结构体作为一个NVS blob写入，避免字段之间不一致
+ */
+class OtaResumeStore {
+    static constexpr const char* TAG = "OtaResumeStore";
+    static constexpr const char* NAMESPACE = "ota_pull";
+    static constexpr const char* KEY = "state";
+
+   public:
+    /**
+     * @brief 读取断点
+     * @return 是否存在有效断点
+     */
+    bool load(OtaResumeState& state) {
+        if (!preferences.begin(NAMESPACE, true)) {
+            return false;
+        }
+        bool found = preferences.getBytesLength(KEY) == sizeof(state) &&
+                     preferences.getBytes(KEY, &state, sizeof(state)) == sizeof(state);
+        preferences.end();
+        return found;
+    }
+
+    /**
+     * @brief 保存断点
+     */
+    void save(const OtaResumeState& state) {
+        if (!preferences.begin(NAMESPACE, false)) {
+            ESP_LOGE(TAG, "Failed to open NVS namespace");
+            return;
+        }
+        if (preferences.putBytes(KEY, &state, sizeof(state)) != sizeof(state)) {
+            ESP_LOGE(TAG, "Failed to save resume state");
+        }
+        preferences.end();
+    }
+
+    /**
+     * @brief 删除断点
+     */
+    void clear() {
+        if (preferences.begin(NAMESPACE, false)) {
+            preferences.remove(KEY);
+            preferences.end();
+        }
+    }
+
+   private:
+    Preferences preferences;
+};
\ No newline at end of file
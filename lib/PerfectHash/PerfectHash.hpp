@@ -0,0 +1,127 @@
+/**
+ * @file PerfectHash.hpp
+ * @brief 编译期完美哈希
+ * @details 对一组编译期已知的键搜索无冲突的哈希种子，运行时查找只需一次哈希和一次比较
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace PerfectHash {
+
+constexpr uint32_t FNV_OFFSET = 2166136261u;
+constexpr uint32_t FNV_PRIME = 16777619u;
+
+/**
+ * @brief FNV-1a哈希（可在编译期求值）
+ * @param data 数据
+ * @param length 数据长度
+ * @param seed 初始值
+ */
+constexpr uint32_t fnv1a(const char* data, size_t length, uint32_t seed = FNV_OFFSET) {
+    uint32_t hash = seed;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief FNV-1a哈希，以'\0'结尾的字符串
+ */
+constexpr uint32_t fnv1a(const char* str, uint32_t seed = FNV_OFFSET) {
+    uint32_t hash = seed;
+    for (; *str; str++) {
+        hash ^= static_cast<uint8_t>(*str);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/**
+ * @brief 编译期字符串比较
+ */
+constexpr bool equals(const char* a, const char* b) {
+    for (; *a && *a == *b; a++, b++) {
+    }
+    return *a == *b;
+}
+
+/**
+ * @brief 完美哈希表：槽位保存键在原数组中的下标
+ * @tparam M 槽位数，必须是2的幂
+ */
+template <size_t M>
+struct Table {
+    static_assert(M > 0 && (M & (M - 1)) == 0, "Slot count must be a power of two");
+
+    uint32_t seed = 0;   // 无冲突的哈希种子，0表示构建失败
+    int16_t slots[M]{};  // 键下标，-1表示空槽
+
+    /**
+     * @brief 是否找到了无冲突的种子
+     */
+    constexpr bool valid() const {
+        return seed != 0;
+    }
+
+    /**
+     * @brief 由哈希值取得键下标
+     * @return 键下标，空槽返回-1（命中后仍需比较键本身）
+     */
+    constexpr int16_t operator[](uint32_t hash) const {
+        return slots[hash & (M - 1)];
+    }
+};
+
+/**
+ * @brief 不小于n的最小2的幂
+ */
+constexpr size_t nextPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) {
+        power <<= 1;
+    }
+    return power;
+}
+
+/**
+ * @brief 为一组键搜索完美哈希种子
+ * @tparam M 槽位数，通常取键数的2~4倍，越大越容易找到种子
+ * @param keys 键数组
+ * @param hash 哈希函数 hash(key, seed)
+ * @return 哈希表，找不到种子时valid()为false，调用方应对结果static_assert
+ */
+template <size_t M, typename Key, size_t N, typename Hash>
+constexpr Table<M> build(const Key (&keys)[N], Hash hash, uint32_t maxAttempts = 4096) {
+    static_assert(N <= M, "More keys than slots");
+
+    for (uint32_t seed = FNV_OFFSET; seed != FNV_OFFSET + maxAttempts; seed++) {
+        Table<M> table;
+        table.seed = seed;
+        for (auto& slot : table.slots) {
+            slot = -1;
+        }
+
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; i++) {
+            int16_t& slot = table.slots[hash(keys[i], seed) & (M - 1)];
+            if (slot >= 0) {
+                collision = true;
+            } else {
+                slot = static_cast<int16_t>(i);
+            }
+        }
+
+        if (!collision) {
+            return table;
+        }
+    }
+
+    return Table<M>{};
+}
+
+}  // namespace PerfectHash
\ No newline at end of file
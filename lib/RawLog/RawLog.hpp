@@ -0,0 +1,652 @@
+/**
+ * @file RawLog.hpp
+ * @brief 直接读写数据分区的环形记录存储
+ * @details 不经过文件系统，按扇区循环使用专用分区，每条记录带CRC，适合最高频的采样数据
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <esp_log.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief 分区环形记录存储
+ *
+ * - 分区按4KB扇区划分，扇区按递增的扇区计数依次使用，计数对扇区数取模即扇区下标
+ * - 每个扇区以扇区头开始：magic(4) 扇区计数(4) 第一条记录序号(4) CRC32(4)
+ * - 记录不跨扇区，按4字节对齐；当前扇区放不下时擦除下一个扇区（即最旧的扇区）继续写入
+ * - 记录先追加到RAM缓冲区，缓冲区满、调用flush()或自动刷新到期时一次写入flash
+ * - 启动时在扇区计数上二分查找最新的扇区，只扫描这一个扇区恢复写入位置；
+ *   复位时写了一半的记录之后不再写入，直接换下一个扇区
+ *
+ * 与LittleFS上的RingLog相比没有元数据和文件操作开销，每个扇区在一圈中只擦除一次，磨损均匀可预期。
+ *
+ * 记录格式：magic(2) 数据长度(2) 序号(4) CRC32(4) 数据 填充
+ *
+ * @note 分区在partitions.csv中定义（应用自定义类型0x40，子类型0x00），分区内容只能由本类写入
+ */
+class RawLog {
+    static constexpr const char* TAG = "RawLog";
+
+   public:
+    // 读取回调，返回false时停止读取
+    using Visitor = std::function<bool(uint32_t seq, const uint8_t* data, size_t length)>;
+
+    static constexpr const char* PARTITION_LABEL = "rawlog";  // 默认分区名称
+    static constexpr uint8_t PARTITION_TYPE = 0x40;           // 分区类型，0x40~0xFE留给应用自定义
+    static constexpr uint8_t PARTITION_SUBTYPE = 0x00;        // 分区子类型
+    static constexpr size_t SECTOR_SIZE = 4096;               // flash扇区（擦除单位）大小
+    static constexpr uint32_t SECTOR_MAGIC = 0x31474C52;      // "RLG1"
+    static constexpr uint16_t RECORD_MAGIC = 0x52AB;
+
+    /**
+     * @param label 分区名称
+     * @param bufferSize RAM缓冲区大小，也是单条记录（含头部）的上限，不超过一个扇区的可用空间
+     */
+    explicit RawLog(const char* label = PARTITION_LABEL, size_t bufferSize = 1024)
+        : label(label), bufferSize(std::min(alignUp(bufferSize), SECTOR_SIZE - SECTOR_HEADER_SIZE)) {}
+
+    ~RawLog() {
+        stopAutoFlush();
+        flush();
+        releasePartition();
+        vSemaphoreDelete(mutex);
+    }
+
+    RawLog(const RawLog&) = delete;
+    RawLog& operator=(const RawLog&) = delete;
+
+    /**
+     * @brief 打开分区，恢复写入位置和序号
+     * @return 是否成功
+     */
+    bool begin() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+
+        const esp_partition_t* found = esp_partition_find_first(
+            static_cast<esp_partition_type_t>(PARTITION_TYPE), static_cast<esp_partition_subtype_t>(PARTITION_SUBTYPE), label
+        );
+        if (found == nullptr || found->size < SECTOR_SIZE * 2) {
+            ESP_LOGE(TAG, "Partition not found or too small: %s", label);
+            xSemaphoreGive(mutex);
+            return false;
+        }
+        if (!claimPartition(found)) {
+            ESP_LOGE(TAG, "Partition %s already opened by another RawLog", label);
+            xSemaphoreGive(mutex);
+            return false;
+        }
+        sectorCount = partition->size / SECTOR_SIZE;
+
+        buffer.reset(new (std::nothrow) uint8_t[bufferSize]);
+        std::unique_ptr<uint8_t[]> sector(new (std::nothrow) uint8_t[SECTOR_SIZE]);
+        if (!buffer || !sector) {
+            ESP_LOGE(TAG, "Failed to allocate buffers");
+            buffer.reset();
+            releasePartition();
+            xSemaphoreGive(mutex);
+            return false;
+        }
+
+        uint32_t start = micros();
+        bool success = recover(sector.get());
+        started = success;
+        if (!success) {
+            releasePartition();
+        } else {
+            ESP_LOGI(
+                TAG,
+                "%s: %u sectors, head %u, records %u..%u, recovered in %u us",
+                label,
+                sectorCount,
+                headCounter,
+                firstSeqLocked(),
+                nextSeq - 1,
+                micros() - start
+            );
+        }
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 追加一条记录
+     * @param data 记录数据
+     * @param length 数据长度
+     * @return 记录序号，失败返回0
+     */
+    uint32_t append(const uint8_t* data, size_t length) {
+        size_t recordSize = alignUp(HEADER_SIZE + length);
+        if (recordSize > bufferSize) {
+            ESP_LOGE(TAG, "%s: record too large: %u bytes", label, length);
+            return 0;
+        }
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        if (!started) {
+            xSemaphoreGive(mutex);
+            return 0;
+        }
+
+        if (headOffset + used + recordSize > SECTOR_SIZE) {
+            flushLocked();
+            if (!advance()) {
+                xSemaphoreGive(mutex);
+                return 0;
+            }
+        } else if (used + recordSize > bufferSize) {
+            flushLocked();
+        }
+
+        RecordHeader header{RECORD_MAGIC, static_cast<uint16_t>(length), nextSeq, 0};
+        header.crc = checksum(header, data);
+        uint8_t* record = buffer.get() + used;
+        memcpy(record, &header, HEADER_SIZE);
+        memcpy(record + HEADER_SIZE, data, length);
+        memset(record + HEADER_SIZE + length, 0xFF, recordSize - HEADER_SIZE - length);
+        used += recordSize;
+        uint32_t seq = nextSeq++;
+
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+    /**
+     * @brief 把缓冲区中的记录写入flash
+     * @return 是否成功
+     */
+    bool flush() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        bool success = flushLocked();
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 启动周期刷新任务
+     * @param intervalMs 刷新间隔
+     * @return 是否启动成功
+     */
+    bool startAutoFlush(uint32_t intervalMs = 1000) {
+        if (taskHandle != nullptr) {
+            ESP_LOGW(TAG, "Auto flush already running");
+            return true;
+        }
+
+        flushIntervalMs = intervalMs;
+        stopSignal = xSemaphoreCreateBinary();
+        done = xSemaphoreCreateBinary();
+        if (stopSignal == nullptr || done == nullptr) {
+            ESP_LOGE(TAG, "Failed to create auto flush signals");
+            deleteSignals();
+            return false;
+        }
+
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& log = *static_cast<RawLog*>(param);
+                // 每个间隔刷新一次，直到收到停止信号
+                while (xSemaphoreTake(log.stopSignal, pdMS_TO_TICKS(log.flushIntervalMs)) != pdTRUE) {
+                    log.flush();
+                }
+                xSemaphoreGive(log.done);
+                vTaskDelete(nullptr);
+            },
+            "raw_log",
+            4096,
+            this,
+            1,
+            &taskHandle
+        );
+
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create auto flush task");
+            taskHandle = nullptr;
+            deleteSignals();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 停止周期刷新任务，等待正在进行的刷新完成后返回
+     */
+    void stopAutoFlush() {
+        if (taskHandle == nullptr) {
+            return;
+        }
+        xSemaphoreGive(stopSignal);
+        xSemaphoreTake(done, portMAX_DELAY);
+        taskHandle = nullptr;
+        deleteSignals();
+    }
+
+    /**
+     * @brief 从指定序号开始顺序读取记录（包括尚未写入flash的记录）
+     * @param fromSeq 起始序号，早于最旧记录时从最旧记录开始
+     * @param visitor 回调
+     * @return 读取的记录数
+     */
+    size_t read(uint32_t fromSeq, const Visitor& visitor) {
+        // 复制写入位置和缓冲区后释放锁，扫描期间不阻塞追加
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        if (!started) {
+            xSemaphoreGive(mutex);
+            return 0;
+        }
+        uint32_t tail = tailCounter;
+        uint32_t head = headCounter;
+        size_t headSize = headOffset;
+        std::vector<uint8_t> pending(buffer.get(), buffer.get() + used);
+        xSemaphoreGive(mutex);
+
+        std::unique_ptr<uint8_t[]> sector(new (std::nothrow) uint8_t[SECTOR_SIZE]);
+        if (!sector) {
+            ESP_LOGE(TAG, "Failed to allocate read buffer");
+            return 0;
+        }
+
+        // 二分查找第一条记录序号不大于fromSeq的最后一个扇区
+        uint32_t lo = tail;
+        uint32_t hi = head;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo + 1) / 2;
+            SectorHeader header;
+            if (readHeader(mid % sectorCount, header) && header.counter == mid && header.firstSeq <= fromSeq) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
+
+        size_t count = 0;
+        Visitor counted = [&](uint32_t seq, const uint8_t* data, size_t length) {
+            count++;
+            return visitor(seq, data, length);
+        };
+
+        for (uint32_t counter = lo; counter <= head; counter++) {
+            size_t limit = counter == head ? headSize : SECTOR_SIZE;
+            size_t end = 0;
+            if (!readSector(counter, sector.get(), limit)) {
+                continue;  // 扫描期间被覆盖
+            }
+            if (parse(sector.get(), SECTOR_HEADER_SIZE, limit, fromSeq, counted, end) == Scan::STOPPED) {
+                return count;
+            }
+        }
+
+        size_t end = 0;
+        parse(pending.data(), 0, pending.size(), fromSeq, counted, end);
+        return count;
+    }
+
+    /**
+     * @brief 擦除所有记录，序号继续递增
+     * @return 是否成功
+     */
+    bool clear() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return false;
+        }
+        bool success = started;
+        if (success) {
+            used = 0;
+            success = esp_partition_erase_range(partition, 0, sectorCount * SECTOR_SIZE) == ESP_OK &&
+                      startSector(0, nextSeq);
+            tailCounter = 0;
+        }
+        xSemaphoreGive(mutex);
+        return success;
+    }
+
+    /**
+     * @brief 最旧记录的序号
+     */
+    uint32_t firstSeq() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        uint32_t seq = firstSeqLocked();
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+    /**
+     * @brief 下一条记录的序号
+     */
+    uint32_t getNextSeq() {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) != pdTRUE) {
+            return 0;
+        }
+        uint32_t seq = nextSeq;
+        xSemaphoreGive(mutex);
+        return seq;
+    }
+
+   private:
+    /**
+     * @brief 删除自动刷新任务的信号量
+     */
+    void deleteSignals() {
+        if (stopSignal) vSemaphoreDelete(stopSignal);
+        if (done) vSemaphoreDelete(done);
+        stopSignal = done = nullptr;
+    }
+
+    struct SectorHeader {
+        uint32_t magic;     // SECTOR_MAGIC
+        uint32_t counter;   // 扇区计数
+        uint32_t firstSeq;  // 扇区中第一条记录的序号
+        uint32_t crc;       // 前三个字段的CRC32
+    };
+
+    struct RecordHeader {
+        uint16_t magic;   // RECORD_MAGIC
+        uint16_t length;  // 数据长度
+        uint32_t seq;     // 序号
+        uint32_t crc;     // 头部（crc为0）和数据的CRC32
+    };
+
+    static constexpr size_t SECTOR_HEADER_SIZE = sizeof(SectorHeader);
+    static constexpr size_t HEADER_SIZE = sizeof(RecordHeader);
+    static constexpr size_t RECORD_ALIGN = 4;
+    static_assert(SECTOR_HEADER_SIZE == 16, "Unexpected sector header size");
+    static_assert(HEADER_SIZE == 12, "Unexpected record header size");
+
+    /**
+     * @brief 已被打开的分区，同一分区有两个实例时各自的写入位置会互相覆盖
+     */
+    struct Registry {
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+        std::vector<const esp_partition_t*> partitions;
+    };
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    /**
+     * @brief 登记本实例使用的分区，分区已被其他实例打开时失败，调用者需持有锁
+     */
+    bool claimPartition(const esp_partition_t* candidate) {
+        if (candidate == partition) {
+            return true;
+        }
+        releasePartition();
+
+        Registry& owners = registry();
+        xSemaphoreTake(owners.mutex, portMAX_DELAY);
+        bool available = std::find(owners.partitions.begin(), owners.partitions.end(), candidate) == owners.partitions.end();
+        if (available) {
+            owners.partitions.push_back(candidate);
+            partition = candidate;
+        }
+        xSemaphoreGive(owners.mutex);
+        return available;
+    }
+
+    /**
+     * @brief 释放本实例使用的分区
+     */
+    void releasePartition() {
+        if (partition == nullptr) {
+            return;
+        }
+        Registry& owners = registry();
+        xSemaphoreTake(owners.mutex, portMAX_DELAY);
+        owners.partitions.erase(std::remove(owners.partitions.begin(), owners.partitions.end(), partition), owners.partitions.end());
+        xSemaphoreGive(owners.mutex);
+        partition = nullptr;
+        started = false;
+    }
+
+    /**
+     * @brief 扫描结果
+     */
+    enum class Scan {
+        END,      // 到达数据末尾（空白区域）
+        CORRUPT,  // 遇到损坏或不完整的记录
+        STOPPED   // 回调要求停止
+    };
+
+    static constexpr size_t alignUp(size_t size) {
+        return (size + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+    }
+
+    /**
+     * @brief 恢复写入位置，调用者需持有锁
+     * @param sector 一个扇区大小的临时缓冲区
+     */
+    bool recover(uint8_t* sector) {
+        SectorHeader first;
+        bool hasHead = false;
+        uint32_t head = 0;
+
+        if (readHeader(0, first) && first.counter % sectorCount == 0) {
+            // 扇区i的计数等于扇区0的计数加i的部分属于同一圈，二分查找这一圈的最后一个扇区
+            uint32_t lo = 0;
+            uint32_t hi = sectorCount - 1;
+            while (lo < hi) {
+                uint32_t mid = lo + (hi - lo + 1) / 2;
+                SectorHeader header;
+                if (readHeader(mid, header) && header.counter == first.counter + mid) {
+                    lo = mid;
+                } else {
+                    hi = mid - 1;
+                }
+            }
+            head = first.counter + lo;
+            hasHead = true;
+        } else {
+            // 扇区0正在换新时复位，其余扇区仍按计数有序，逐个比较
+            for (uint32_t i = 1; i < sectorCount; i++) {
+                SectorHeader header;
+                if (readHeader(i, header) && header.counter % sectorCount == i && (!hasHead || header.counter > head)) {
+                    head = header.counter;
+                    hasHead = true;
+                }
+            }
+        }
+
+        if (!hasHead) {
+            ESP_LOGI(TAG, "%s: no valid sectors, initializing", label);
+            tailCounter = 0;
+            nextSeq = 1;
+            return startSector(0, nextSeq);
+        }
+
+        // 最旧的扇区：上一圈中下一个扇区开始的第一个有效扇区
+        tailCounter = head >= sectorCount - 1 ? head - (sectorCount - 1) : 0;
+        SectorHeader header;
+        while (tailCounter < head && !(readHeader(tailCounter % sectorCount, header) && header.counter == tailCounter)) {
+            tailCounter++;
+        }
+
+        // 扫描最新扇区中的记录
+        headCounter = head;
+        if (!readSector(head, sector, SECTOR_SIZE)) {
+            return false;
+        }
+        memcpy(&header, sector, SECTOR_HEADER_SIZE);
+        nextSeq = header.firstSeq;
+        size_t end = 0;
+        Scan result = parse(sector, SECTOR_HEADER_SIZE, SECTOR_SIZE, 0, [&](uint32_t seq, const uint8_t*, size_t) {
+            nextSeq = seq + 1;
+            return true;
+        }, end);
+        headOffset = end;
+
+        // 有效记录之后不是空白：复位时写了一半，该扇区不再写入
+        if (result == Scan::CORRUPT || !isErased(sector + end, SECTOR_SIZE - end)) {
+            ESP_LOGW(TAG, "%s: torn write in sector %u at %u, sealing", label, head % sectorCount, end);
+            headOffset = SECTOR_SIZE;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 擦除下一个扇区并写入扇区头，调用者需持有锁
+     */
+    bool advance() {
+        if (!startSector(headCounter + 1, nextSeq)) {
+            return false;
+        }
+        if (headCounter - tailCounter >= sectorCount) {
+            tailCounter = headCounter - sectorCount + 1;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 擦除counter对应的扇区并写入扇区头，成功后成为最新扇区
+     */
+    bool startSector(uint32_t counter, uint32_t firstSeq) {
+        size_t offset = (counter % sectorCount) * SECTOR_SIZE;
+        SectorHeader header{SECTOR_MAGIC, counter, firstSeq, 0};
+        header.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, crc));
+
+        esp_err_t err = esp_partition_erase_range(partition, offset, SECTOR_SIZE);
+        if (err == ESP_OK) {
+            err = esp_partition_write(partition, offset, &header, SECTOR_HEADER_SIZE);
+        }
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: failed to start sector %u: %s", label, counter % sectorCount, esp_err_to_name(err));
+            return false;
+        }
+        headCounter = counter;
+        headOffset = SECTOR_HEADER_SIZE;
+        return true;
+    }
+
+    /**
+     * @brief 读取并校验扇区头
+     */
+    bool readHeader(uint32_t index, SectorHeader& header) const {
+        if (esp_partition_read(partition, index * SECTOR_SIZE, &header, SECTOR_HEADER_SIZE) != ESP_OK) {
+            return false;
+        }
+        return header.magic == SECTOR_MAGIC &&
+               header.crc == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, crc));
+    }
+
+    /**
+     * @brief 读取扇区的前length字节，并确认扇区计数仍为counter
+     */
+    bool readSector(uint32_t counter, uint8_t* sector, size_t length) const {
+        if (esp_partition_read(partition, (counter % sectorCount) * SECTOR_SIZE, sector, length) != ESP_OK) {
+            return false;
+        }
+        SectorHeader header;
+        memcpy(&header, sector, SECTOR_HEADER_SIZE);
+        return header.magic == SECTOR_MAGIC && header.counter == counter &&
+               header.crc == esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(SectorHeader, crc));
+    }
+
+    /**
+     * @brief 解析[begin, limit)中的记录
+     * @param end 输出最后一条有效记录的结束位置
+     */
+    Scan parse(const uint8_t* data, size_t begin, size_t limit, uint32_t fromSeq, const Visitor& visitor, size_t& end)
+        const {
+        end = begin;
+        while (limit - end >= HEADER_SIZE) {
+            RecordHeader header;
+            memcpy(&header, data + end, HEADER_SIZE);
+            if (header.magic == 0xFFFF) {
+                return Scan::END;
+            }
+            size_t recordSize = alignUp(HEADER_SIZE + header.length);
+            if (header.magic != RECORD_MAGIC || recordSize > limit - end) {
+                return Scan::CORRUPT;
+            }
+
+            const uint8_t* payload = data + end + HEADER_SIZE;
+            if (checksum(header, payload) != header.crc) {
+                return Scan::CORRUPT;
+            }
+            end += recordSize;
+            if (header.seq >= fromSeq && !visitor(header.seq, payload, header.length)) {
+                return Scan::STOPPED;
+            }
+        }
+        return Scan::END;
+    }
+
+    static uint32_t checksum(RecordHeader header, const uint8_t* data) {
+        header.crc = 0;
+        uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), HEADER_SIZE);
+        return esp_rom_crc32_le(crc, data, header.length);
+    }
+
+    static bool isErased(const uint8_t* data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] != 0xFF) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 写入缓冲区，调用者需持有锁；写入失败时丢弃缓冲区中的记录并停止写入该扇区
+     */
+    bool flushLocked() {
+        if (used == 0) {
+            return true;
+        }
+
+        size_t offset = (headCounter % sectorCount) * SECTOR_SIZE + headOffset;
+        esp_err_t err = esp_partition_write(partition, offset, buffer.get(), used);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "%s: write failed at 0x%x: %s, %u bytes dropped", label, offset, esp_err_to_name(err), used);
+            headOffset = SECTOR_SIZE;
+            used = 0;
+            return false;
+        }
+        headOffset += used;
+        used = 0;
+        return true;
+    }
+
+    uint32_t firstSeqLocked() const {
+        SectorHeader header;
+        if (readHeader(tailCounter % sectorCount, header) && header.counter == tailCounter) {
+            return header.firstSeq;
+        }
+        return nextSeq;
+    }
+
+    const char* label;                                  // 分区名称
+    const size_t bufferSize;                            // RAM缓冲区大小
+    const esp_partition_t* partition = nullptr;         // 数据分区
+    uint32_t sectorCount = 0;                           // 扇区数
+    uint32_t headCounter = 0;                           // 最新扇区的计数
+    uint32_t tailCounter = 0;                           // 最旧扇区的计数
+    size_t headOffset = 0;                              // 最新扇区中已写入flash的字节数
+    uint32_t nextSeq = 1;                               // 下一条记录的序号
+    std::unique_ptr<uint8_t[]> buffer;                  // RAM缓冲区
+    size_t used = 0;                                    // 缓冲区已用字节数
+    bool started = false;                               // 是否已打开
+    uint32_t flushIntervalMs = 1000;                    // 自动刷新间隔
+    TaskHandle_t taskHandle = nullptr;                  // 自动刷新任务
+    SemaphoreHandle_t stopSignal = nullptr;             // 通知自动刷新任务退出
+    SemaphoreHandle_t done = nullptr;                   // 自动刷新任务退出信号
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 互斥锁
+};
\ No newline at end of file
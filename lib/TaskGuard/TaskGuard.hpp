@@ -1,3 +1,6 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 /**
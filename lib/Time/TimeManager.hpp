@@ -1,5 +1,6 @@
 #pragma once
 
+#include <KvStore.hpp>
 #include <Preferences.h>
 #include <sys/time.h>
 #include <time.h>
@@ -39,19 +40,27 @@ class TimeManager {
 
         // 初始化配置存储
         preferences.begin(preference_namespace, false);
-
-        // 从存储中读取NTP服务器列表
-        String saved_servers = preferences.getString("ntp_servers", "");
-        if (!saved_servers.isEmpty()) {
-            char* server = strtok((char*)saved_servers.c_str(), ",");
-            while (server != nullptr) {
-                ntp_servers.push_back(std::string(server));
-                server = strtok(nullptr, ",");
+        ntp_servers_key = std::string(preference_namespace) + ".ntp_servers";
+
+        // 从KvStore读取NTP服务器列表
+        ntp_servers = KvStore::getInstance().getStrings(ntp_servers_key.c_str());
+        if (ntp_servers.empty()) {
+            // 旧版本保存在Preferences中（逗号分隔），读取后迁移到KvStore
+            String saved_servers = preferences.getString("ntp_servers", "");
+            if (!saved_servers.isEmpty()) {
+                char* server = strtok((char*)saved_servers.c_str(), ",");
+                while (server != nullptr) {
+                    ntp_servers.push_back(std::string(server));
+                    server = strtok(nullptr, ",");
+                }
+            } else {
+                // 默认使用主流NTP服务器
+                ntp_servers = {"ntp.aliyun.com", "ntp.ntsc.ac.cn", "cn.ntp.org.cn"};
+            }
+            if (saveNtpServers() && !saved_servers.isEmpty()) {
+                preferences.remove("ntp_servers");
+                ESP_LOGI(TAG, "Migrated NTP servers from Preferences");
             }
-        } else {
-            // 默认使用主流NTP服务器
-            ntp_servers = {"ntp.aliyun.com", "ntp.ntsc.ac.cn", "cn.ntp.org.cn"};
-            saveNtpServers();
         }
 
         // 从存储中读取上次同步的时间戳
@@ -184,21 +193,29 @@ class TimeManager {
     TimeManager& operator=(const TimeManager&) = delete;  // 禁止赋值
 
     std::vector<std::string> ntp_servers;
+    std::string ntp_servers_key;
     Preferences preferences;
     volatile SyncStatus sync_status;
     volatile time_t last_sync_timestamp;
     volatile uint8_t sync_retry_count;
     static const uint8_t MAX_SYNC_RETRIES = 3;
 
-    // 保存NTP服务器列表到持久化存储
-    void saveNtpServers() {
+    // 保存NTP服务器列表到KvStore，返回是否成功
+    bool saveNtpServers() {
+        if (KvStore::getInstance().setStrings(ntp_servers_key.c_str(), ntp_servers)) {
+            ESP_LOGI(TAG, "Saved %u NTP servers", ntp_servers.size());
+            return true;
+        }
+
+        // 文件系统不可用时仍保存到Preferences
         std::stringstream ss;
         for (size_t i = 0; i < ntp_servers.size(); ++i) {
             if (i > 0) ss << ",";
             ss << ntp_servers[i];
         }
         preferences.putString("ntp_servers", ss.str().c_str());
-        ESP_LOGI(TAG, "Saved NTP servers: %s", ss.str().c_str());
+        ESP_LOGW(TAG, "Saved NTP servers to Preferences: %s", ss.str().c_str());
+        return false;
     }
 
     // 更新SNTP服务器配置
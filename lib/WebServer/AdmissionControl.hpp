@@ -0,0 +1,324 @@
+/**
+ * @file AdmissionControl.hpp
+ * @brief Web请求准入控制
+ * @details 按路由限制并发数、按全局预算限制在途字节数，超限时直接返回503而不是排队
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief 请求准入控制器
+ *
+ * 准入判断发生在请求头解析完成、请求体开始接收之前：
+ * - 全局在途请求数不超过maxInFlight
+ * - 匹配路由前缀的请求数不超过该路由的并发上限
+ * - 在途字节数（请求体长度 + 预留响应大小）不超过byteBudget
+ * - 内部RAM空闲量不低于heapFloor（PSRAM不计入，TCP缓冲区和请求状态都在内部RAM中）
+ *
+ * 被拒绝的请求返回503并带Retry-After头；通过的请求在连接断开时释放占用。
+ * WebSocket升级请求是长连接，不参与准入统计。
+ *
+ * @note 所有回调都在async_tcp任务中执行；路由限制应在服务器启动前配置。
+ */
+class AdmissionControl {
+    static constexpr const char* TAG = "AdmissionControl";
+
+   public:
+    static constexpr size_t MAX_SLOTS = 16;  // 同时跟踪的在途请求数上限
+    static constexpr size_t MAX_ROUTES = 8;  // 路由限制条目上限
+
+    /**
+     * @brief 全局准入配置
+     */
+    struct Config {
+        uint8_t maxInFlight = 8;            // 全局并发请求上限（不超过MAX_SLOTS）
+        size_t byteBudget = 48 * 1024;      // 全局在途字节预算
+        size_t defaultReserve = 2 * 1024;   // 每个请求预留的响应字节数
+        size_t heapFloor = 32 * 1024;       // 内部RAM空闲量低于该值时拒绝新请求
+        uint32_t retryAfterSeconds = 2;     // 503响应的Retry-After值
+    };
+
+    /**
+     * @brief 请求结束回调
+     * @param tag 请求标签（如路由指标下标）
+     * @param elapsedUs 从准入到最后一次addBytesOut()（响应的最后一个字节入队）的耗时（微秒），
+     *                  没有记录响应字节时为到连接关闭的耗时
+     * @param bytesIn 请求体字节数
+     * @param bytesOut 已记录的响应字节数
+     */
+    using CompletionHook =
+        std::function<void(int tag, uint32_t elapsedUs, uint32_t bytesIn, uint32_t bytesOut)>;
+
+    /**
+     * @brief 准入统计
+     */
+    struct Stats {
+        uint32_t admitted;       // 累计通过的请求数
+        uint32_t shed;           // 累计拒绝的请求数
+        uint32_t inFlight;       // 当前在途请求数
+        uint32_t inFlightBytes;  // 当前在途字节数
+    };
+
+    /**
+     * @brief 设置全局配置
+     */
+    void setConfig(const Config& newConfig) {
+        config = newConfig;
+        if (config.maxInFlight > MAX_SLOTS) {
+            config.maxInFlight = MAX_SLOTS;
+        }
+    }
+
+    /**
+     * @brief 设置路由限制
+     * @param prefix 路由前缀（如"/api/ota"），按路径段匹配，"/api/ota"匹配"/api/ota/x"但不匹配"/api/otax"
+     * @param maxConcurrent 并发上限
+     * @param reserve 每个请求预留的响应字节数，0表示使用默认值
+     * @param streamsBody 请求体是否流式处理（如OTA上传），流式请求体不计入在途字节
+     * @return 设置是否成功
+     */
+    bool setRouteLimit(
+        const char* prefix, uint8_t maxConcurrent, size_t reserve = 0, bool streamsBody = false
+    ) {
+        RouteLimit* route = findRouteByPrefix(prefix);
+        if (!route) {
+            if (routeCount >= MAX_ROUTES) {
+                ESP_LOGE(TAG, "Too many route limits");
+                return false;
+            }
+            route = &routes[routeCount++];
+            strlcpy(route->prefix, prefix, sizeof(route->prefix));
+            route->active = 0;
+        }
+
+        route->maxConcurrent = maxConcurrent;
+        route->reserve = reserve;
+        route->streamsBody = streamsBody;
+        return true;
+    }
+
+    /**
+     * @brief 设置请求结束回调，只对打过标签的请求调用
+     */
+    void setCompletionHook(CompletionHook hook) {
+        completionHook = std::move(hook);
+    }
+
+    /**
+     * @brief 为在途请求设置标签，重复设置时以最后一次为准
+     */
+    void tag(AsyncWebServerRequest* request, int value) {
+        if (Slot* slot = findSlot(request)) {
+            slot->tag = value;
+        }
+    }
+
+    /**
+     * @brief 累加在途请求的响应字节数，在响应交给send()或分块响应生成每一块时调用
+     * @details 同时记录时间，最后一次调用即响应的最后一个字节入队的时刻
+     */
+    void addBytesOut(AsyncWebServerRequest* request, size_t bytes) {
+        if (Slot* slot = findSlot(request)) {
+            slot->bytesOut += bytes;
+            slot->queuedUs = micros();
+        }
+    }
+
+    /**
+     * @brief 为在途请求设置连接断开回调
+     * @details 请求只能设置一个onDisconnect回调，准入的请求已由本类占用，其他模块需通过这里设置；
+     *          未经准入的请求（如WebSocket升级）直接设置到请求上
+     */
+    void onDisconnect(AsyncWebServerRequest* request, std::function<void()> callback) {
+        if (Slot* slot = findSlot(request)) {
+            slot->onDisconnect = std::move(callback);
+        } else {
+            request->onDisconnect(std::move(callback));
+        }
+    }
+
+    /**
+     * @brief 在服务器上安装准入检查
+     * @param server Web服务器，必须在其他处理器之前调用，保证最先参与匹配
+     */
+    void attach(AsyncWebServer& server) {
+        // 只有需要拒绝的请求才会匹配到这个处理器，其余请求继续匹配后面的处理器
+        server
+            .on("/*",
+                HTTP_ANY,
+                [this](AsyncWebServerRequest* request) { reject(request); })
+            .setFilter([this](AsyncWebServerRequest* request) { return !admit(request); });
+    }
+
+    /**
+     * @brief 获取统计
+     */
+    Stats getStats() const {
+        return {admitted.load(), shed.load(), inFlight.load(), inFlightBytes.load()};
+    }
+
+   private:
+    struct RouteLimit {
+        char prefix[32];        // 路由前缀
+        uint8_t maxConcurrent;  // 并发上限
+        uint8_t active;         // 当前并发数
+        size_t reserve;         // 预留响应字节数
+        bool streamsBody;       // 请求体是否流式处理
+    };
+
+    struct Slot {
+        AsyncWebServerRequest* request;      // 占用该槽位的请求，nullptr表示空闲
+        size_t bytes;                        // 计入预算的字节数
+        RouteLimit* route;                   // 匹配的路由限制
+        uint32_t startUs;                    // 准入时间
+        uint32_t queuedUs;                   // 最后一次记录响应字节的时间，0表示未记录
+        uint32_t bytesIn;                    // 请求体字节数
+        uint32_t bytesOut;                   // 响应字节数
+        int tag;                             // 请求标签，-1表示未设置
+        std::function<void()> onDisconnect;  // 其他模块设置的断开回调
+    };
+
+    /**
+     * @brief 判断请求能否准入，准入时占用槽位并在连接断开时释放
+     * @return 是否准入
+     */
+    bool admit(AsyncWebServerRequest* request) {
+        if (request->hasHeader("Upgrade")) {
+            return true;
+        }
+
+        RouteLimit* route = matchRoute(request->url().c_str());
+        size_t reserve = route && route->reserve ? route->reserve : config.defaultReserve;
+        size_t body = route && route->streamsBody ? 0 : request->contentLength();
+        size_t bytes = body + reserve;
+
+        Slot* slot = nullptr;
+        if (inFlight.load() < config.maxInFlight) {
+            for (auto& candidate : slots) {
+                if (candidate.request == nullptr) {
+                    slot = &candidate;
+                    break;
+                }
+            }
+        }
+
+        const char* reason = nullptr;
+        if (!slot) {
+            reason = "too many requests in flight";
+        } else if (route && route->active >= route->maxConcurrent) {
+            reason = "route concurrency limit";
+        } else if (inFlightBytes.load() + bytes > config.byteBudget) {
+            reason = "byte budget exceeded";
+        } else if (heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < config.heapFloor + bytes) {
+            reason = "heap floor";
+        }
+
+        if (reason) {
+            shed++;
+            ESP_LOGW(TAG, "Shedding %s: %s", request->url().c_str(), reason);
+            return false;
+        }
+
+        *slot = {
+            request,
+            bytes,
+            route,
+            static_cast<uint32_t>(micros()),
+            0,
+            static_cast<uint32_t>(request->contentLength()),
+            0,
+            -1
+        };
+        if (route) route->active++;
+        inFlight++;
+        inFlightBytes += bytes;
+        admitted++;
+
+        request->onDisconnect([this, request]() { release(request); });
+        return true;
+    }
+
+    void release(AsyncWebServerRequest* request) {
+        Slot* slot = findSlot(request);
+        if (!slot) return;
+
+        if (slot->tag >= 0 && completionHook) {
+            uint32_t endUs = slot->queuedUs ? slot->queuedUs : static_cast<uint32_t>(micros());
+            completionHook(slot->tag, endUs - slot->startUs, slot->bytesIn, slot->bytesOut);
+        }
+
+        if (slot->route && slot->route->active > 0) slot->route->active--;
+        inFlight--;
+        inFlightBytes -= slot->bytes;
+        std::function<void()> callback = std::move(slot->onDisconnect);
+        *slot = {};
+        if (callback) {
+            callback();
+        }
+    }
+
+    Slot* findSlot(AsyncWebServerRequest* request) {
+        for (auto& slot : slots) {
+            if (slot.request == request) {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    void reject(AsyncWebServerRequest* request) {
+        AsyncWebServerResponse* response =
+            request->beginResponse(503, "text/plain", "Service Unavailable");
+        response->addHeader("Retry-After", String(config.retryAfterSeconds));
+        request->send(response);
+    }
+
+    RouteLimit* matchRoute(const char* url) {
+        RouteLimit* best = nullptr;
+        size_t bestLength = 0;
+        for (size_t i = 0; i < routeCount; i++) {
+            size_t length = strlen(routes[i].prefix);
+            if (length > bestLength && matchesPrefix(url, routes[i].prefix, length)) {
+                best = &routes[i];
+                bestLength = length;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief 前缀只在路径段边界处匹配
+     */
+    static bool matchesPrefix(const char* url, const char* prefix, size_t length) {
+        if (strncmp(url, prefix, length) != 0) {
+            return false;
+        }
+        return url[length] == '\0' || url[length] == '/' || (length > 0 && prefix[length - 1] == '/');
+    }
+
+    RouteLimit* findRouteByPrefix(const char* prefix) {
+        for (size_t i = 0; i < routeCount; i++) {
+            if (strcmp(routes[i].prefix, prefix) == 0) {
+                return &routes[i];
+            }
+        }
+        return nullptr;
+    }
+
+    Config config;
+    Slot slots[MAX_SLOTS] = {};
+    RouteLimit routes[MAX_ROUTES] = {};
+    size_t routeCount = 0;
+    CompletionHook completionHook;
+    std::atomic<uint32_t> admitted{0};
+    std::atomic<uint32_t> shed{0};
+    std::atomic<uint32_t> inFlight{0};
+    std::atomic<uint32_t> inFlightBytes{0};
+};
\ No newline at end of file
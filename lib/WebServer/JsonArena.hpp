@@ -0,0 +1,133 @@
+/**
+ * @file JsonArena.hpp
+ * @brief 固定大小的ArduinoJson内存池
+ * @details 为JsonDocument提供预分配的线性内存，解析/序列化过程不再访问堆
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @brief 固定容量的线性分配器
+ *
+ * - 每块内存前保存块大小，支持reallocate
+ * - 只有最后分配的块能原地扩缩或真正释放，其余释放操作在reset()时统一回收
+ * - 容量耗尽时返回nullptr，JsonDocument会将其报告为NoMemory/overflowed
+ *
+ * @tparam N 内存池字节数
+ */
+template <size_t N>
+class JsonArena : public ArduinoJson::Allocator {
+   public:
+    void* allocate(size_t size) override {
+        size_t total = blockSize(size);
+        if (used + total > N) {
+            return nullptr;
+        }
+
+        auto* header = reinterpret_cast<size_t*>(pool + used);
+        *header = size;
+        last = used;
+        used += total;
+        if (used > peak) {
+            peak = used;
+        }
+        return pool + last + HEADER_SIZE;
+    }
+
+    void deallocate(void* ptr) override {
+        if (ptr != nullptr && offsetOf(ptr) == last) {
+            used = last;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (ptr == nullptr) {
+            return allocate(newSize);
+        }
+
+        size_t offset = offsetOf(ptr);
+        auto* header = reinterpret_cast<size_t*>(pool + offset);
+
+        // 最后一块：原地调整
+        if (offset == last) {
+            size_t total = blockSize(newSize);
+            if (offset + total > N) {
+                return nullptr;
+            }
+            *header = newSize;
+            used = offset + total;
+            if (used > peak) {
+                peak = used;
+            }
+            return ptr;
+        }
+
+        // 收缩：直接复用
+        if (newSize <= *header) {
+            *header = newSize;
+            return ptr;
+        }
+
+        void* moved = allocate(newSize);
+        if (moved != nullptr) {
+            memcpy(moved, ptr, *header);
+        }
+        return moved;
+    }
+
+    /**
+     * @brief 回收全部内存，调用前必须确保使用该内存池的JsonDocument已销毁或已clear()
+     */
+    void reset() {
+        used = 0;
+        last = SIZE_MAX;
+    }
+
+    /**
+     * @brief 已使用字节数
+     */
+    size_t size() const {
+        return used;
+    }
+
+    /**
+     * @brief 历史最高使用字节数
+     */
+    size_t peakSize() const {
+        return peak;
+    }
+
+    /**
+     * @brief 内存池容量
+     */
+    static constexpr size_t capacity() {
+        return N;
+    }
+
+   private:
+    static constexpr size_t ALIGNMENT = alignof(max_align_t);
+
+    static constexpr size_t alignUp(size_t size) {
+        return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    static constexpr size_t HEADER_SIZE = alignUp(sizeof(size_t));  // 块头，保证返回地址对齐
+
+    static constexpr size_t blockSize(size_t size) {
+        return HEADER_SIZE + alignUp(size);
+    }
+
+    size_t offsetOf(void* ptr) const {
+        return reinterpret_cast<uint8_t*>(ptr) - HEADER_SIZE - pool;
+    }
+
+    alignas(max_align_t) uint8_t pool[N];
+    size_t used = 0;
+    size_t last = SIZE_MAX;  // 最后一块的偏移
+    size_t peak = 0;
+};
\ No newline at end of file
@@ -0,0 +1,406 @@
+/**
+ * @file JsonResponse.hpp
+ * @brief 分块序列化的JSON响应
+ * @details 响应体按TCP发送窗口逐块发送，不占用内部RAM拼出完整的JSON字符串
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "JsonArena.hpp"
+
+/**
+ * @brief JSON响应构造器
+ *
+ * - fromDocument()：已有文档，一次性序列化到PSRAM缓冲区，之后每块只做拷贝
+ * - fromItems()：数组元素由回调逐个生成，每个元素使用固定内存池，整体内存与元素数量无关；
+ *   元素超出内存池时改用PSRAM上的文档重新生成该元素
+ *
+ * 每个端点的内部RAM峰值占用会被记录，可通过heapStats()查看，用于评估接口的内存开销。
+ * 堆空闲量是全局的，与其他响应重叠的样本不计入峰值，需在单个请求依次执行的受控负载下测量。
+ */
+class JsonResponse {
+    static constexpr const char* TAG = "JsonResponse";
+
+   public:
+    // 数组元素生成回调：向item写入第index个元素，没有更多元素时返回false
+    // 元素超出内存池时同一index会以新文档再调用一次，回调不能依赖调用次数
+    using ItemProducer = std::function<bool(size_t index, JsonDocument& item)>;
+    // 响应字节发送回调：每生成一块响应体调用一次
+    using SendObserver = void (*)(AsyncWebServerRequest* request, size_t bytes);
+
+    static constexpr size_t ITEM_ARENA_SIZE = 2048;  // 单个数组元素的内存池大小
+    static constexpr size_t MAX_ENDPOINTS = 16;      // 堆占用统计的端点数上限
+
+    /**
+     * @brief 单个端点的堆占用统计
+     */
+    struct HeapStats {
+        char endpoint[32];  // 端点路径
+        uint32_t count;      // 响应次数
+        uint32_t contended;  // 与其他响应重叠、未计入峰值的次数
+        uint32_t peak;       // 内部RAM历史峰值（字节）
+        uint32_t last;       // 最近一次计入的峰值（字节）
+    };
+
+    /**
+     * @brief 由已有文档创建定长响应
+     * @param request 请求
+     * @param doc 文档，所有权转移给响应
+     * @param code HTTP状态码
+     */
+    static AsyncWebServerResponse* fromDocument(
+        AsyncWebServerRequest* request, JsonDocument&& doc, int code = 200
+    ) {
+        auto probe = std::make_shared<HeapProbe>(request->url().c_str(), HeapProbe::freeInternal());
+        size_t length = measureJson(doc);
+
+        // 只序列化一次，发送时按index拷贝
+        auto* data = static_cast<uint8_t*>(allocate(length + 1));
+        if (data == nullptr) {
+            ESP_LOGE(TAG, "No memory for %u byte response", length);
+            return request->beginResponse(503, "text/plain", "Out of memory");
+        }
+        std::shared_ptr<uint8_t> body(data, heap_caps_free);
+        serializeJson(doc, reinterpret_cast<char*>(data), length + 1);
+        probe->sample();
+
+        AsyncWebServerResponse* response = request->beginResponse(
+            "application/json",
+            length,
+            [request, body, length, probe](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t n = index < length ? std::min(maxLen, length - index) : 0;
+                memcpy(buffer, body.get() + index, n);
+                probe->sample();
+                notifySent(request, n);
+                return n;
+            }
+        );
+        response->setCode(code);
+        return response;
+    }
+
+    /**
+     * @brief 创建流式数组响应（分块传输）
+     * @param request 请求
+     * @param producer 数组元素生成回调，在async_tcp任务中按需调用
+     */
+    static AsyncWebServerResponse* fromItems(
+        AsyncWebServerRequest* request, ItemProducer producer
+    ) {
+        auto state = std::make_shared<ArrayState>(
+            std::move(producer), request->url().c_str(), HeapProbe::freeInternal()
+        );
+
+        return request->beginChunkedResponse(
+            "application/json",
+            [request, state](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t written = state->fill(buffer, maxLen);
+                state->probe.sample();
+                notifySent(request, written);
+                return written;
+            }
+        );
+    }
+
+    /**
+     * @brief 获取各端点的堆占用统计
+     * @return 统计快照
+     */
+    static std::vector<HeapStats> heapStats() {
+        std::vector<HeapStats> result;
+        auto& registry = statsRegistry();
+        if (xSemaphoreTake(registry.mutex, portMAX_DELAY) == pdTRUE) {
+            result.assign(registry.entries, registry.entries + registry.size);
+            xSemaphoreGive(registry.mutex);
+        }
+        return result;
+    }
+
+    /**
+     * @brief 设置响应字节发送回调（如路由指标统计）
+     */
+    static void setSendObserver(SendObserver observer) {
+        sendObserver() = observer;
+    }
+
+   private:
+    static SendObserver& sendObserver() {
+        static SendObserver observer = nullptr;
+        return observer;
+    }
+
+    static void notifySent(AsyncWebServerRequest* request, size_t bytes) {
+        if (sendObserver() && bytes > 0) {
+            sendObserver()(request, bytes);
+        }
+    }
+
+    /**
+     * @brief 分配响应缓冲区，优先使用PSRAM
+     */
+    static void* allocate(size_t size) {
+        void* ptr = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        return ptr ? ptr : heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+
+    /**
+     * @brief 优先使用PSRAM的ArduinoJson分配器，用于超出内存池的数组元素
+     */
+    class PsramAllocator : public ArduinoJson::Allocator {
+       public:
+        void* allocate(size_t size) override {
+            return JsonResponse::allocate(size);
+        }
+
+        void deallocate(void* ptr) override {
+            heap_caps_free(ptr);
+        }
+
+        void* reallocate(void* ptr, size_t newSize) override {
+            void* moved = heap_caps_realloc(ptr, newSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+            return moved ? moved : heap_caps_realloc(ptr, newSize, MALLOC_CAP_8BIT);
+        }
+    };
+
+    static PsramAllocator& psramAllocator() {
+        static PsramAllocator allocator;
+        return allocator;
+    }
+
+    /**
+     * @brief 只输出[skip, skip + capacity)区间的Print
+     */
+    class WindowPrint : public Print {
+       public:
+        WindowPrint(uint8_t* out, size_t capacity, size_t skip)
+            : out(out), capacity(capacity), skip(skip) {}
+
+        size_t write(uint8_t c) override {
+            return write(&c, 1);
+        }
+
+        size_t write(const uint8_t* data, size_t len) override {
+            size_t consumed = len;
+            if (skip >= len) {
+                skip -= len;
+                return consumed;
+            }
+            data += skip;
+            len -= skip;
+            skip = 0;
+
+            size_t n = std::min(len, capacity - written);
+            memcpy(out + written, data, n);
+            written += n;
+            return consumed;
+        }
+
+        size_t size() const {
+            return written;
+        }
+
+       private:
+        uint8_t* out;
+        size_t capacity;
+        size_t skip;
+        size_t written = 0;
+    };
+
+    /**
+     * @brief 统计单次响应期间内部RAM空闲量的低水位相对响应开始时的降幅
+     * @details 只统计MALLOC_CAP_INTERNAL，不含PSRAM；期间有其他响应进行时样本标记为重叠
+     */
+    class HeapProbe {
+       public:
+        HeapProbe(const char* endpoint, size_t baseline)
+            : endpoint(endpoint), baseline(baseline), lowWater(baseline), contended(active()++ > 0) {}
+
+        ~HeapProbe() {
+            active()--;
+            record(endpoint.c_str(), baseline - lowWater, contended);
+        }
+
+        const char* name() const {
+            return endpoint.c_str();
+        }
+
+        void sample() {
+            lowWater = std::min(lowWater, freeInternal());
+            if (active() > 1) {
+                contended = true;
+            }
+        }
+
+        static size_t freeInternal() {
+            return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        }
+
+       private:
+        // 进行中的响应数，创建和销毁都在async_tcp任务中
+        static std::atomic<uint32_t>& active() {
+            static std::atomic<uint32_t> count{0};
+            return count;
+        }
+
+        String endpoint;
+        size_t baseline;
+        size_t lowWater;  // 响应期间内部RAM空闲量的最小值
+        bool contended;   // 是否与其他响应重叠
+    };
+
+    /**
+     * @brief 流式数组的生成状态
+     */
+    struct ArrayState {
+        enum class Phase { OPEN, ITEMS, CLOSE, DONE };
+
+        ArrayState(ItemProducer producer, const char* endpoint, size_t baseline)
+            : producer(std::move(producer)), probe(endpoint, baseline) {}
+
+        size_t fill(uint8_t* buffer, size_t maxLen) {
+            size_t written = 0;
+            while (written < maxLen) {
+                // 先发送上一块没放下的剩余内容
+                if (pendingOffset < pending.size()) {
+                    size_t n = std::min(pending.size() - pendingOffset, maxLen - written);
+                    memcpy(buffer + written, pending.data() + pendingOffset, n);
+                    pendingOffset += n;
+                    written += n;
+                    continue;
+                }
+
+                switch (phase) {
+                    case Phase::OPEN:
+                        buffer[written++] = '[';
+                        phase = Phase::ITEMS;
+                        break;
+
+                    case Phase::ITEMS:
+                        if (!nextItem(buffer, maxLen, written)) {
+                            phase = Phase::CLOSE;
+                        }
+                        break;
+
+                    case Phase::CLOSE:
+                        buffer[written++] = ']';
+                        phase = Phase::DONE;
+                        break;
+
+                    case Phase::DONE:
+                        return written;
+                }
+            }
+            return written;
+        }
+
+        /**
+         * @brief 生成下一个元素，放得下时直接写入发送块，否则暂存到pending
+         * @return 是否还有元素，元素生成失败时也返回false
+         */
+        bool nextItem(uint8_t* buffer, size_t maxLen, size_t& written) {
+            arena.reset();
+            JsonDocument small(&arena);
+            if (!producer(index, small)) {
+                return false;
+            }
+
+            // 超出内存池时改用PSRAM上的文档重新生成，避免截断输出
+            JsonDocument large(&psramAllocator());
+            JsonDocument* doc = &small;
+            if (small.overflowed()) {
+                if (!producer(index, large)) {
+                    return false;
+                }
+                doc = &large;
+            }
+            if (doc->overflowed()) {
+                // 不写入结尾的']'，客户端会得到无法解析的响应而不是缺少字段的数据
+                ESP_LOGE(TAG, "Item %u of %s overflowed, response aborted", index, probe.name());
+                phase = Phase::DONE;
+                return true;
+            }
+            JsonDocument& item = *doc;
+
+            size_t separator = index > 0 ? 1 : 0;
+            size_t length = measureJson(item) + separator;
+            index++;
+
+            if (length <= maxLen - written) {
+                if (separator) buffer[written++] = ',';
+                WindowPrint direct(buffer + written, maxLen - written, 0);
+                serializeJson(item, direct);
+                written += direct.size();
+            } else {
+                pending.resize(length);
+                pendingOffset = 0;
+                if (separator) pending[0] = ',';
+                WindowPrint deferred(pending.data() + separator, length - separator, 0);
+                serializeJson(item, deferred);
+            }
+            return true;
+        }
+
+        ItemProducer producer;
+        HeapProbe probe;
+        Phase phase = Phase::OPEN;
+        size_t index = 0;
+        std::vector<uint8_t> pending;  // 跨块的元素剩余内容
+        size_t pendingOffset = 0;
+        JsonArena<ITEM_ARENA_SIZE> arena;
+    };
+
+    struct StatsRegistry {
+        HeapStats entries[MAX_ENDPOINTS];
+        size_t size = 0;
+        SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+    };
+
+    static StatsRegistry& statsRegistry() {
+        static StatsRegistry registry;
+        return registry;
+    }
+
+    static void record(const char* endpoint, size_t peak, bool contended) {
+        auto& registry = statsRegistry();
+        if (xSemaphoreTake(registry.mutex, portMAX_DELAY) != pdTRUE) {
+            return;
+        }
+
+        HeapStats* stats = nullptr;
+        for (size_t i = 0; i < registry.size; i++) {
+            if (strncmp(registry.entries[i].endpoint, endpoint, sizeof(stats->endpoint) - 1) == 0) {
+                stats = &registry.entries[i];
+                break;
+            }
+        }
+        if (!stats && registry.size < MAX_ENDPOINTS) {
+            stats = &registry.entries[registry.size++];
+            strlcpy(stats->endpoint, endpoint, sizeof(stats->endpoint));
+            stats->count = stats->contended = stats->peak = stats->last = 0;
+        }
+
+        if (stats && contended) {
+            stats->count++;
+            stats->contended++;
+        } else if (stats) {
+            stats->count++;
+            stats->last = peak;
+            if (peak > stats->peak) {
+                stats->peak = peak;
+            }
+        }
+        xSemaphoreGive(registry.mutex);
+    }
+};
\ No newline at end of file
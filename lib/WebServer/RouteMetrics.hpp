@@ -0,0 +1,289 @@
+/**
+ * @file RouteMetrics.hpp
+ * @brief 按路由统计的Web请求指标
+ * @details 固定大小的路由表，计数全部使用32位原子变量，记录路径上不加锁，可按Prometheus文本格式导出
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_log.h>
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <memory>
+#include <string>
+
+/**
+ * @brief 路由指标表
+ *
+ * - 每个路由记录请求数、请求体字节数、响应字节数和延迟直方图
+ * - 路由在启动阶段注册，注册后下标固定，记录时只做原子加法
+ * - Xtensa上只有32位原子操作是无锁的，计数器达到2^32后回绕，Prometheus会按计数器重置处理；
+ *   耗时按毫秒累计，回绕前可累计约49天
+ * - 耗时从准入到响应的最后一个字节入队，不包含网络传输和连接关闭
+ * - 导出时逐个指标族生成，响应按发送窗口分块，不拼接完整文本
+ */
+class RouteMetrics {
+    static constexpr const char* TAG = "RouteMetrics";
+
+   public:
+    // 响应字节发送回调
+    using SendObserver = void (*)(AsyncWebServerRequest* request, size_t bytes);
+
+    static constexpr size_t MAX_ROUTES = 24;  // 路由数上限
+    static constexpr size_t BUCKET_COUNT = 9;
+    static constexpr uint32_t BUCKETS_MS[BUCKET_COUNT] = {
+        5, 10, 25, 50, 100, 250, 500, 1000, 2500
+    };  // 直方图桶上界（毫秒），另有+Inf桶
+
+    /**
+     * @brief 注册路由
+     * @param path 路由路径
+     * @param method HTTP方法名
+     * @return 路由下标，表满时返回-1
+     */
+    int add(const char* path, const char* method) {
+        size_t count = size.load();
+        for (size_t i = 0; i < count; i++) {
+            if (strcmp(routes[i].path, path) == 0 && strcmp(routes[i].method, method) == 0) {
+                return i;
+            }
+        }
+        if (count >= MAX_ROUTES) {
+            ESP_LOGE(TAG, "Route table full, %s not tracked", path);
+            return -1;
+        }
+
+        Route& route = routes[count];
+        strlcpy(route.path, path, sizeof(route.path));
+        strlcpy(route.method, method, sizeof(route.method));
+        size.store(count + 1);  // 先写完条目再发布
+        return count;
+    }
+
+    /**
+     * @brief 记录一次请求
+     * @param index 路由下标
+     * @param elapsedUs 从准入到响应的最后一个字节入队的耗时（微秒）
+     * @param bytesIn 请求体字节数
+     * @param bytesOut 响应字节数
+     */
+    void record(int index, uint32_t elapsedUs, uint32_t bytesIn, uint32_t bytesOut) {
+        if (index < 0 || static_cast<size_t>(index) >= size.load()) {
+            return;
+        }
+
+        Route& route = routes[index];
+        route.count.fetch_add(1, std::memory_order_relaxed);
+        route.bytesIn.fetch_add(bytesIn, std::memory_order_relaxed);
+        route.bytesOut.fetch_add(bytesOut, std::memory_order_relaxed);
+        route.sumMs.fetch_add((elapsedUs + 500) / 1000, std::memory_order_relaxed);
+
+        size_t bucket = 0;
+        while (bucket < BUCKET_COUNT && elapsedUs > BUCKETS_MS[bucket] * 1000) {
+            bucket++;
+        }
+        route.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 以Prometheus文本格式发送全部指标（分块传输）
+     * @param request 请求
+     * @param observer 每生成一块响应体调用一次，用于统计响应字节数
+     */
+    void send(AsyncWebServerRequest* request, SendObserver observer = nullptr) const {
+        auto state = std::make_shared<ExportState>(this);
+        request->send(request->beginChunkedResponse(
+            "text/plain; version=0.0.4",
+            [state, request, observer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t written = state->fill(buffer, maxLen);
+                if (observer && written > 0) {
+                    observer(request, written);
+                }
+                return written;
+            }
+        ));
+    }
+
+    /**
+     * @brief 获取HTTP方法名
+     */
+    static const char* methodName(WebRequestMethodComposite method) {
+        switch (method) {
+            case HTTP_GET:
+                return "GET";
+            case HTTP_POST:
+                return "POST";
+            case HTTP_DELETE:
+                return "DELETE";
+            case HTTP_PUT:
+                return "PUT";
+            case HTTP_PATCH:
+                return "PATCH";
+            case HTTP_HEAD:
+                return "HEAD";
+            case HTTP_OPTIONS:
+                return "OPTIONS";
+            default:
+                return "ANY";
+        }
+    }
+
+   private:
+    struct Route {
+        char path[32];                                      // 路由路径
+        char method[8];                                     // HTTP方法
+        std::atomic<uint32_t> count{0};                     // 请求数
+        std::atomic<uint32_t> bytesIn{0};                   // 请求体字节数
+        std::atomic<uint32_t> bytesOut{0};                  // 响应字节数
+        std::atomic<uint32_t> sumMs{0};                     // 累计耗时（毫秒）
+        std::atomic<uint32_t> buckets[BUCKET_COUNT + 1]{};  // 各桶计数（非累计）
+    };
+
+    /**
+     * @brief 导出指标族
+     */
+    enum class Family { REQUESTS, BYTES_IN, BYTES_OUT, DURATION, DONE };
+
+    /**
+     * @brief 导出状态：按（指标族, 路由）逐段生成文本
+     */
+    struct ExportState {
+        explicit ExportState(const RouteMetrics* metrics) : metrics(metrics) {}
+
+        size_t fill(uint8_t* buffer, size_t maxLen) {
+            size_t written = 0;
+            while (written < maxLen) {
+                if (offset >= pending.size()) {
+                    if (!next()) break;
+                    continue;
+                }
+                size_t n = std::min(pending.size() - offset, maxLen - written);
+                memcpy(buffer + written, pending.data() + offset, n);
+                offset += n;
+                written += n;
+            }
+            return written;
+        }
+
+        /**
+         * @brief 生成下一段文本
+         * @return 是否还有内容
+         */
+        bool next() {
+            pending.clear();
+            offset = 0;
+
+            if (family == Family::DONE) {
+                return false;
+            }
+
+            if (route == 0) {
+                appendHeader();
+            }
+            if (route < metrics->size.load()) {
+                appendRoute(metrics->routes[route]);
+                route++;
+            } else {
+                family = static_cast<Family>(static_cast<int>(family) + 1);
+                route = 0;
+            }
+            return true;
+        }
+
+        void appendHeader() {
+            switch (family) {
+                case Family::REQUESTS:
+                    pending += "# HELP http_requests_total Completed HTTP requests.\n"
+                               "# TYPE http_requests_total counter\n";
+                    break;
+                case Family::BYTES_IN:
+                    pending += "# HELP http_request_bytes_total Request body bytes received.\n"
+                               "# TYPE http_request_bytes_total counter\n";
+                    break;
+                case Family::BYTES_OUT:
+                    pending += "# HELP http_response_bytes_total Response bytes sent.\n"
+                               "# TYPE http_response_bytes_total counter\n";
+                    break;
+                case Family::DURATION:
+                    pending += "# HELP http_request_duration_seconds Time from request receipt to the last response byte queued.\n"
+                               "# TYPE http_request_duration_seconds histogram\n";
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void appendRoute(const Route& r) {
+            char labels[64];
+            snprintf(labels, sizeof(labels), "path=\"%s\",method=\"%s\"", r.path, r.method);
+
+            switch (family) {
+                case Family::REQUESTS:
+                    appendLine("http_requests_total", labels, r.count.load());
+                    break;
+                case Family::BYTES_IN:
+                    appendLine("http_request_bytes_total", labels, r.bytesIn.load());
+                    break;
+                case Family::BYTES_OUT:
+                    appendLine("http_response_bytes_total", labels, r.bytesOut.load());
+                    break;
+                case Family::DURATION: {
+                    char line[192];
+                    uint64_t cumulative = 0;
+                    for (size_t i = 0; i <= BUCKET_COUNT; i++) {
+                        cumulative += r.buckets[i].load();
+                        if (i < BUCKET_COUNT) {
+                            snprintf(
+                                line,
+                                sizeof(line),
+                                "http_request_duration_seconds_bucket{%s,le=\"%.3f\"} %" PRIu64 "\n",
+                                labels,
+                                BUCKETS_MS[i] / 1000.0,
+                                cumulative
+                            );
+                        } else {
+                            snprintf(
+                                line,
+                                sizeof(line),
+                                "http_request_duration_seconds_bucket{%s,le=\"+Inf\"} %" PRIu64 "\n",
+                                labels,
+                                cumulative
+                            );
+                        }
+                        pending += line;
+                    }
+                    snprintf(
+                        line,
+                        sizeof(line),
+                        "http_request_duration_seconds_sum{%s} %.3f\n",
+                        labels,
+                        r.sumMs.load() / 1e3
+                    );
+                    pending += line;
+                    appendLine("http_request_duration_seconds_count", labels, cumulative);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+
+        void appendLine(const char* name, const char* labels, uint64_t value) {
+            char line[192];
+            snprintf(line, sizeof(line), "%s{%s} %" PRIu64 "\n", name, labels, value);
+            pending += line;
+        }
+
+        const RouteMetrics* metrics;
+        Family family = Family::REQUESTS;
+        size_t route = 0;
+        std::string pending;  // 当前段文本
+        size_t offset = 0;    // 当前段已发送长度
+    };
+
+    Route routes[MAX_ROUTES];
+    std::atomic<size_t> size{0};
+};
\ No newline at end of file
@@ -0,0 +1,93 @@
+/**
+ * @file StaticRouteTable.hpp
+ * @brief 编译期路由表
+ * @details 方法+路径在编译期构建完美哈希，请求分发只需一次哈希和一次字符串比较
+ */
+
+#pragma once
+
+#include <ESPAsyncWebServer.h>
+#include <PerfectHash.hpp>
+#include <cstring>
+
+// 静态路由处理函数，body在请求结束前有效，无请求体时为nullptr
+using StaticRouteHandler = void (*)(AsyncWebServerRequest* request, const uint8_t* body, size_t length);
+
+/**
+ * @brief 静态路由
+ */
+struct StaticRoute {
+    WebRequestMethod method;     // HTTP方法（单一方法，不能是HTTP_ANY）
+    const char* path;            // 完整路径
+    StaticRouteHandler handler;  // 处理函数
+    size_t maxBodySize;          // 请求体大小上限，0表示不接受请求体
+};
+
+/**
+ * @brief 编译期路由表
+ *
+ * 用法：
+ * @code
+ * static constexpr StaticRoute routes[] = {
+ *     {HTTP_GET, "/api/led", handleGet, 0},
+ *     {HTTP_POST, "/api/led", handlePost, 2048},
+ * };
+ * static constexpr StaticRouteTable table(routes);
+ * static_assert(table.valid(), "Duplicate routes or no perfect hash seed");
+ * web.addStaticRoutes("/api/led", table);
+ * @endcode
+ *
+ * @tparam N 路由数
+ * @tparam M 哈希槽位数
+ */
+template <size_t N, size_t M = PerfectHash::nextPowerOfTwo(N * 4)>
+class StaticRouteTable {
+   public:
+    constexpr StaticRouteTable(const StaticRoute (&routes)[N])
+        : table(PerfectHash::build<M>(routes, hashRoute)) {
+        for (size_t i = 0; i < N; i++) {
+            this->routes[i] = routes[i];
+        }
+    }
+
+    /**
+     * @brief 是否构建成功（重复路由会导致构建失败）
+     */
+    constexpr bool valid() const {
+        return table.valid();
+    }
+
+    /**
+     * @brief 查找路由
+     * @param method 请求方法
+     * @param path 请求路径（不含查询参数）
+     * @return 路由下标，未找到返回-1
+     */
+    int find(WebRequestMethodComposite method, const char* path) const {
+        int16_t index = table[hashKey(method, path, table.seed)];
+        if (index < 0 || routes[index].method != method || strcmp(routes[index].path, path) != 0) {
+            return -1;
+        }
+        return index;
+    }
+
+    constexpr const StaticRoute& operator[](size_t index) const {
+        return routes[index];
+    }
+
+    static constexpr size_t size() {
+        return N;
+    }
+
+   private:
+    static constexpr uint32_t hashKey(uint32_t method, const char* path, uint32_t seed) {
+        return PerfectHash::fnv1a(path, seed ^ (method * 0x9E3779B1u));
+    }
+
+    static constexpr uint32_t hashRoute(const StaticRoute& route, uint32_t seed) {
+        return hashKey(route.method, route.path, seed);
+    }
+
+    StaticRoute routes[N]{};
+    PerfectHash::Table<M> table;
+};
\ No newline at end of file
@@ -0,0 +1,253 @@
+/**
+ * @file TelemetryChannel.hpp
+ * @brief 基于WebSocket的设备状态推送通道
+ * @details 按固定周期采集各数据源，只推送发生变化的字段，所有客户端共享同一份序列化缓冲区
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <TaskGuard.hpp>
+#include <atomic>
+#include <functional>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 遥测推送通道
+ *
+ * - 每个数据源对应消息中的一个顶层字段，由回调填充
+ * - 每个周期只采集一次，与上次状态比较后生成增量
+ * - 增量只序列化一次，通过textAll()广播，客户端列表只由库在持有其内部锁时访问
+ * - 有新客户端连接或收到"resync"文本消息时，下一周期广播一次完整快照
+ *
+ * 消息的seq连续递增。发送队列已满的客户端会被库丢弃消息，客户端发现seq不连续时应发送"resync"，
+ * 在收到完整快照（"full": true）之前忽略增量。
+ */
+class TelemetryChannel {
+    static constexpr const char* TAG = "TelemetryChannel";
+
+   public:
+    // 数据源回调：向传入的对象中写入当前状态
+    using Source = std::function<void(JsonObject)>;
+
+    /**
+     * @brief 推送配置
+     */
+    struct Config {
+        uint32_t intervalMs = 1000;          // 推送周期(ms)，同一周期内的变化会合并
+        uint32_t taskStackSize = 4 * 1024U;  // 任务堆栈大小
+        UBaseType_t taskPriority = 1;        // 任务优先级
+    };
+
+    /**
+     * @brief 推送统计
+     */
+    struct Stats {
+        uint32_t sequence;  // 已广播的消息序号
+        uint32_t fulls;     // 已广播的完整快照数
+        uint32_t resyncs;   // 客户端请求完整快照的次数
+        size_t clients;     // 当前连接的客户端数
+    };
+
+    /**
+     * @brief 构造函数
+     * @param path WebSocket路径
+     */
+    explicit TelemetryChannel(const char* path) : socket(new AsyncWebSocket(path)) {
+        socket->onEvent([this](
+                           AsyncWebSocket* server,
+                           AsyncWebSocketClient* client,
+                           AwsEventType type,
+                           void* arg,
+                           uint8_t* data,
+                           size_t len
+                       ) { handleEvent(client, type, arg, data, len); });
+    }
+
+    ~TelemetryChannel() {
+        taskGuard.reset();
+        if (mutex != nullptr) {
+            vSemaphoreDelete(mutex);
+            mutex = nullptr;
+        }
+    }
+
+    /**
+     * @brief 获取WebSocket处理器，用于注册到服务器
+     * @note 处理器注册后由AsyncWebServer持有并负责释放
+     */
+    AsyncWebSocket* handler() {
+        return socket;
+    }
+
+    /**
+     * @brief 添加数据源
+     * @param key 消息中的字段名
+     * @param source 数据源回调
+     */
+    void addSource(const char* key, Source source) {
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            sources.push_back({key, std::move(source)});
+            xSemaphoreGive(mutex);
+        }
+    }
+
+    /**
+     * @brief 启动周期推送任务
+     * @param newConfig 推送配置
+     * @return 启动是否成功
+     */
+    bool start(const Config& newConfig) {
+        if (taskHandle != nullptr) {
+            ESP_LOGW(TAG, "Telemetry task already running");
+            return true;
+        }
+
+        config = newConfig;
+        taskGuard = std::make_unique<TaskGuard>(taskHandle);
+        BaseType_t xReturned = xTaskCreate(
+            [](void* param) {
+                auto& channel = *static_cast<TelemetryChannel*>(param);
+                channel.publishTask();
+            },
+            "telemetry",
+            config.taskStackSize,
+            this,
+            config.taskPriority,
+            &taskHandle
+        );
+
+        if (xReturned != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create telemetry task");
+            return false;
+        }
+
+        ESP_LOGI(TAG, "Telemetry started, interval: %u ms", config.intervalMs);
+        return true;
+    }
+
+    /**
+     * @brief 立即采集并推送一次
+     */
+    void publish() {
+        if (clientCount.load() == 0) {
+            return;
+        }
+
+        // 采集当前状态
+        JsonDocument current;
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            for (const auto& source : sources) {
+                source.callback(current[source.key].to<JsonObject>());
+            }
+            xSemaphoreGive(mutex);
+        }
+
+        JsonDocument message;
+        bool full = fullRequested.exchange(false);
+        if (full) {
+            message["full"] = true;
+            message["data"] = current;
+        } else {
+            JsonObject changes = message["data"].to<JsonObject>();
+            JsonObjectConst previous = lastState.as<JsonObjectConst>();
+            for (JsonPairConst kv : current.as<JsonObjectConst>()) {
+                if (previous[kv.key()] != kv.value()) {
+                    changes[kv.key()] = kv.value();
+                }
+            }
+            if (changes.size() == 0) {
+                return;
+            }
+        }
+
+        // 只有实际广播的消息才占用序号，客户端据此发现丢失的增量
+        message["seq"] = ++sequence;
+        socket->textAll(serialize(message));
+        if (full) {
+            fulls++;
+        }
+        lastState = std::move(current);
+    }
+
+    /**
+     * @brief 获取推送统计
+     */
+    Stats getStats() {
+        return {sequence, fulls, resyncs, clientCount};
+    }
+
+   private:
+    TelemetryChannel(const TelemetryChannel&) = delete;
+    TelemetryChannel& operator=(const TelemetryChannel&) = delete;
+
+    static constexpr const char* RESYNC_REQUEST = "resync";  // 客户端请求完整快照的消息
+
+    struct SourceEntry {
+        std::string key;
+        Source callback;
+    };
+
+    /**
+     * @brief 处理连接事件和客户端消息
+     * @note 在async_tcp任务中调用，与客户端列表的修改在同一任务，可以安全地清理多余的客户端
+     */
+    void handleEvent(AsyncWebSocketClient* client, AwsEventType type, void* arg, uint8_t* data, size_t len) {
+        if (type == WS_EVT_CONNECT) {
+            socket->cleanupClients();
+            clientCount++;
+            // 新客户端先收到完整快照，之后只收增量
+            fullRequested = true;
+            ESP_LOGD(TAG, "Telemetry client #%u connected", client->id());
+        } else if (type == WS_EVT_DISCONNECT) {
+            clientCount--;
+            ESP_LOGD(TAG, "Telemetry client #%u disconnected", client->id());
+        } else if (type == WS_EVT_DATA) {
+            auto* info = static_cast<AwsFrameInfo*>(arg);
+            bool whole = info->final && info->index == 0 && info->len == len && info->opcode == WS_TEXT;
+            if (whole && len == strlen(RESYNC_REQUEST) && memcmp(data, RESYNC_REQUEST, len) == 0) {
+                fullRequested = true;
+                resyncs++;
+            }
+        }
+    }
+
+    void publishTask() {
+        TickType_t lastWakeTime = xTaskGetTickCount();
+        const TickType_t frequency = pdMS_TO_TICKS(config.intervalMs);
+
+        while (true) {
+            publish();
+            vTaskDelayUntil(&lastWakeTime, frequency);
+        }
+    }
+
+    static AsyncWebSocketSharedBuffer serialize(const JsonDocument& doc) {
+        size_t length = measureJson(doc);
+        auto buffer = std::make_shared<std::vector<uint8_t>>(length + 1);
+        serializeJson(doc, reinterpret_cast<char*>(buffer->data()), buffer->size());
+        buffer->resize(length);  // 去掉结尾的'\0'
+        return buffer;
+    }
+
+    AsyncWebSocket* socket;  // 由AsyncWebServer持有
+    Config config;
+    std::vector<SourceEntry> sources;
+    JsonDocument lastState;                  // 上次推送的完整状态，仅推送任务访问
+    std::atomic<bool> fullRequested{false};  // 下次推送是否广播完整快照
+    std::atomic<size_t> clientCount{0};      // 当前连接的客户端数
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> fulls{0};
+    std::atomic<uint32_t> resyncs{0};
+    TaskHandle_t taskHandle = nullptr;
+    std::unique_ptr<TaskGuard> taskGuard;
+    SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+};
\ No newline at end of file
@@ -7,25 +7,53 @@
 
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
+#include <LittleFSController.hpp>
 #include <esp_log.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <string>
+#include "AdmissionControl.hpp"
+#include "JsonResponse.hpp"
+#include "RouteMetrics.hpp"
+#include "StaticRouteTable.hpp"
+#include "TelemetryChannel.hpp"
 
 /**
  * @brief Web服务器控制器类
  *
  * 这个类提供了一个通用的Web服务器实现，支持：
  * - 静态文件服务
- * - API路由注册
+ * - API路由注册（含编译期完美哈希路由表）
  * - SPA（单页应用）路由
  * - 自定义404处理
+ * - 设备状态推送（WebSocket）
+ * - 请求准入控制（超出并发或内存预算时返回503）
+ * - 按路由统计请求数、字节数和延迟（Prometheus格式导出）
  */
 class WebServerController {
     static constexpr const char* TAG = "WebServerController";
+    static constexpr const char* DEFAULT_FILE = "index.html";    // 目录的默认文件
+    static constexpr const char* CACHE_CONTROL = "max-age=600";  // 静态文件的缓存策略
+    static constexpr const char* NOT_FOUND_PAGE = "/404.html";   // 默认404页面
 
    public:
     // 定义请求处理器函数类型
     using RequestHandler = std::function<void(AsyncWebServerRequest*)>;
+    // 带请求体的处理器函数类型，body在请求结束前有效
+    using BodyHandler =
+        std::function<void(AsyncWebServerRequest*, const uint8_t* body, size_t length)>;
+    // 流式上传处理器函数类型，数据到达时逐段调用；total为0表示总长度未知（multipart上传）
+    using UploadHandler = std::function<void(
+        AsyncWebServerRequest*,
+        const uint8_t* data,
+        size_t length,
+        size_t index,
+        size_t total,
+        bool final
+    )>;
 
     /**
      * @brief 获取单例实例
@@ -57,26 +85,60 @@ class WebServerController {
                 return false;
             }
 
-            // 使用serveStatic设置静态文件服务
-            if (webRoot && strlen(webRoot) > 0) {
-                server->serveStatic("/", LittleFS, webRoot)
-                    .setDefaultFile("index.html")
-                    .setCacheControl("max-age=600");
-            }
+            // 准入检查必须最先注册，保证在其他处理器之前参与匹配
+            admission.attach(*server);
+            admission.setCompletionHook(
+                [this](int route, uint32_t elapsedUs, uint32_t bytesIn, uint32_t bytesOut) {
+                    metrics.record(route, elapsedUs, bytesIn, bytesOut);
+                }
+            );
+            JsonResponse::setSendObserver(countBytesOut);
 
-            // 设置默认404处理
-            server->onNotFound([this](AsyncWebServerRequest* request) {
-                if (notFoundHandler) {
-                    notFoundHandler(request);
+            // 静态文件服务：Web根目录在资源清单中时由清单回答存在性、大小和MIME类型，
+            // 不存在的路径在过滤器中就被排除，不会访问flash；否则使用serveStatic
+            if (webRoot && strlen(webRoot) > 0) {
+                assetRoot = webRoot;
+                while (!assetRoot.empty() && assetRoot.back() == '/') {
+                    assetRoot.pop_back();
+                }
+                int route = metrics.add("/*", "GET");
+                size_t rootLength = strlen(LittleFSController::MANIFEST_ROOT);
+                bool inManifest =
+                    assetRoot.compare(0, rootLength, LittleFSController::MANIFEST_ROOT) == 0 &&
+                    (assetRoot.size() == rootLength || assetRoot[rootLength] == '/');
+                if (inManifest) {
+                    server
+                        ->on("/*",
+                             HTTP_GET,
+                             [this](AsyncWebServerRequest* request) { serveAsset(request); })
+                        .setFilter([this, route](AsyncWebServerRequest* request) {
+                            // 过滤器先于方法匹配执行，非GET请求在这里排除，解析结果不会留给其他处理器
+                            if (request->method() != HTTP_GET) {
+                                return false;
+                            }
+                            std::string path;
+                            AssetManifest::Info info;
+                            bool plain;
+                            if (!resolveAsset(request->url().c_str(), path, info, plain)) {
+                                return false;
+                            }
+                            stashAsset(request, path, info, plain);
+                            admission.tag(request, route);
+                            return true;
+                        });
                 } else {
-                    // 默认404处理：尝试发送404.html，如果不存在则发送简单文本
-                    if (LittleFS.exists("/404.html")) {
-                        request->send(LittleFS, "/404.html", "text/html", false);
-                    } else {
-                        request->send(404, "text/plain", "404");
-                    }
+                    server->serveStatic("/", LittleFS, webRoot)
+                        .setDefaultFile(DEFAULT_FILE)
+                        .setCacheControl(CACHE_CONTROL)
+                        .setFilter(routeTagger(route));
                 }
-            });
+            }
+
+            // 设置默认404处理，404页面的存在性按根目录代数缓存，扫描器产生的大量404不会访问flash
+            notFoundGeneration = LittleFSController::getInstance().getDirGeneration("/");
+            hasNotFoundPage = LittleFSController::getInstance().exists(NOT_FOUND_PAGE);
+            notFoundRoute = metrics.add("404", "ANY");
+            server->onNotFound([this](AsyncWebServerRequest* request) { handleNotFound(request); });
             isInitialized = true;
 
             ESP_LOGI(TAG, "Web server isInitialized, port: %d, root: %s", port, webRoot);
@@ -98,7 +160,209 @@ class WebServerController {
             return;
         }
 
-        server->on(path, method, [handler](AsyncWebServerRequest* request) { handler(request); });
+        server->on(path, method, [handler](AsyncWebServerRequest* request) { handler(request); })
+            .setFilter(routeTagger(metrics.add(path, RouteMetrics::methodName(method))));
+    }
+
+    /**
+     * @brief 添加带请求体的API端点处理器
+     * @param path API路径
+     * @param method HTTP方法
+     * @param handler 请求处理函数，在请求体接收完整后调用
+     * @param maxBodySize 请求体大小上限，超过时返回413
+     */
+    void addBodyHandler(
+        const char* path, WebRequestMethod method, BodyHandler handler, size_t maxBodySize = 4096
+    ) {
+        if (!isInitialized || !server) {
+            ESP_LOGE(TAG, "Web server not initialized");
+            return;
+        }
+
+        server->on(
+            path,
+            method,
+            [handler](AsyncWebServerRequest* request) { invokeWithBody(request, handler); },
+            nullptr,
+            [maxBodySize](
+                AsyncWebServerRequest* request,
+                uint8_t* data,
+                size_t len,
+                size_t index,
+                size_t total
+            ) { collectBody(request, data, len, index, total, maxBodySize); }
+        )
+            .setFilter(routeTagger(metrics.add(path, RouteMetrics::methodName(method))));
+    }
+
+    /**
+     * @brief 添加流式上传端点处理器，请求体不在内存中缓存
+     * @details 同时支持原始请求体（application/octet-stream）和multipart文件上传
+     * @param path API路径
+     * @param method HTTP方法
+     * @param onComplete 请求体接收完毕后调用，负责发送响应
+     * @param onChunk 每段数据到达时调用
+     */
+    void addUploadHandler(
+        const char* path, WebRequestMethod method, RequestHandler onComplete, UploadHandler onChunk
+    ) {
+        if (!isInitialized || !server) {
+            ESP_LOGE(TAG, "Web server not initialized");
+            return;
+        }
+
+        server->on(
+            path,
+            method,
+            [onComplete](AsyncWebServerRequest* request) { onComplete(request); },
+            [onChunk](
+                AsyncWebServerRequest* request,
+                const String& filename,
+                size_t index,
+                uint8_t* data,
+                size_t len,
+                bool final
+            ) { onChunk(request, data, len, index, 0, final); },
+            [onChunk](
+                AsyncWebServerRequest* request,
+                uint8_t* data,
+                size_t len,
+                size_t index,
+                size_t total
+            ) { onChunk(request, data, len, index, total, index + len == total); }
+        )
+            .setFilter(routeTagger(metrics.add(path, RouteMetrics::methodName(method))));
+    }
+
+    /**
+     * @brief 添加编译期路由表
+     * @details 整张表只注册一个服务器处理器，按方法+路径完美哈希直接找到处理函数
+     * @param prefix 路由表独占的路径前缀，需在与其重叠的其他路由之前注册
+     * @param table 路由表，必须具有静态存储期
+     */
+    template <size_t N, size_t M>
+    void addStaticRoutes(const char* prefix, const StaticRouteTable<N, M>& table) {
+        if (!isInitialized || !server) {
+            ESP_LOGE(TAG, "Web server not initialized");
+            return;
+        }
+        if (!table.valid()) {
+            ESP_LOGE(TAG, "Invalid route table for %s", prefix);
+            return;
+        }
+
+        std::array<int, N> routeIds;
+        for (size_t i = 0; i < N; i++) {
+            routeIds[i] = metrics.add(table[i].path, RouteMetrics::methodName(table[i].method));
+        }
+
+        const auto* routes = &table;
+        String uri = String(prefix) + "*";
+        server->on(
+            uri.c_str(),
+            HTTP_ANY,
+            [this, routes, routeIds](AsyncWebServerRequest* request) {
+                int index = routes->find(request->method(), request->url().c_str());
+                if (index < 0) {
+                    handleNotFound(request);
+                    return;
+                }
+                admission.tag(request, routeIds[index]);
+                invokeWithBody(request, (*routes)[index].handler);
+            },
+            nullptr,
+            [routes](
+                AsyncWebServerRequest* request,
+                uint8_t* data,
+                size_t len,
+                size_t index,
+                size_t total
+            ) {
+                int route = routes->find(request->method(), request->url().c_str());
+                size_t maxBodySize = route < 0 ? 0 : (*routes)[route].maxBodySize;
+                collectBody(request, data, len, index, total, maxBodySize);
+            }
+        );
+    }
+
+    /**
+     * @brief 发送JSON文档，响应体按发送窗口分块序列化
+     * @param request 请求
+     * @param doc 文档，所有权转移给响应
+     * @param code HTTP状态码
+     */
+    static void sendJson(AsyncWebServerRequest* request, JsonDocument&& doc, int code = 200) {
+        request->send(JsonResponse::fromDocument(request, std::move(doc), code));
+    }
+
+    /**
+     * @brief 发送文本响应并计入路由指标的响应字节数
+     * @param request 请求
+     * @param code HTTP状态码
+     * @param contentType 内容类型
+     * @param content 响应内容
+     */
+    static void sendText(
+        AsyncWebServerRequest* request, int code, const char* contentType, const char* content
+    ) {
+        countBytesOut(request, strlen(content));
+        request->send(code, contentType, content);
+    }
+
+    /**
+     * @brief 发送JSON数组，元素由回调逐个生成，内存占用与元素数量无关
+     * @param request 请求
+     * @param producer 元素生成回调
+     */
+    static void sendJsonArray(AsyncWebServerRequest* request, JsonResponse::ItemProducer producer) {
+        request->send(JsonResponse::fromItems(request, std::move(producer)));
+    }
+
+    /**
+     * @brief 添加JSON响应堆占用统计端点
+     * @param path 端点路径
+     */
+    void addHeapStatsHandler(const char* path = "/api/debug/heap") {
+        addApiHandler(path, HTTP_GET, [](AsyncWebServerRequest* request) {
+            auto stats = std::make_shared<std::vector<JsonResponse::HeapStats>>(
+                JsonResponse::heapStats()
+            );
+            sendJsonArray(request, [stats](size_t index, JsonDocument& item) {
+                if (index >= stats->size()) return false;
+                const auto& entry = (*stats)[index];
+                item["endpoint"] = entry.endpoint;
+                item["count"] = entry.count;
+                item["contended"] = entry.contended;
+                item["peak"] = entry.peak;
+                item["last"] = entry.last;
+                return true;
+            });
+        });
+    }
+
+    /**
+     * @brief 添加路由指标端点（Prometheus文本格式）
+     * @param path 端点路径
+     */
+    void addMetricsHandler(const char* path = "/metrics") {
+        addApiHandler(path, HTTP_GET, [this](AsyncWebServerRequest* request) {
+            metrics.send(request, countBytesOut);
+        });
+    }
+
+    /**
+     * @brief 添加自定义处理器（如WebSocket）
+     * @param handler 处理器，注册后由服务器持有并负责释放
+     * @return 添加是否成功
+     */
+    bool addHandler(AsyncWebHandler* handler) {
+        if (!isInitialized || !server) {
+            ESP_LOGE(TAG, "Web server not initialized");
+            return false;
+        }
+
+        server->addHandler(handler);
+        return true;
     }
 
     /**
@@ -114,6 +378,97 @@ class WebServerController {
         notFoundHandler = handler;
     }
 
+    /**
+     * @brief 设置请求准入配置
+     * @param config 全局并发、字节预算和堆下限
+     */
+    void setAdmissionConfig(const AdmissionControl::Config& config) {
+        admission.setConfig(config);
+    }
+
+    /**
+     * @brief 设置路由并发限制
+     * @param prefix 路由前缀
+     * @param maxConcurrent 并发上限
+     * @param reserve 每个请求预留的响应字节数，0表示使用默认值
+     * @param streamsBody 请求体是否流式处理，流式请求体不计入在途字节
+     * @return 设置是否成功
+     */
+    bool setRouteLimit(
+        const char* prefix, uint8_t maxConcurrent, size_t reserve = 0, bool streamsBody = false
+    ) {
+        return admission.setRouteLimit(prefix, maxConcurrent, reserve, streamsBody);
+    }
+
+    /**
+     * @brief 设置请求的连接断开回调
+     * @details 请求的onDisconnect已被准入控制占用，直接调用request->onDisconnect()会使其槽位无法释放
+     * @param request 请求
+     * @param callback 断开回调，在async_tcp任务中调用
+     */
+    void onDisconnect(AsyncWebServerRequest* request, std::function<void()> callback) {
+        admission.onDisconnect(request, std::move(callback));
+    }
+
+    /**
+     * @brief 获取请求准入统计
+     */
+    AdmissionControl::Stats getAdmissionStats() const {
+        return admission.getStats();
+    }
+
+    /**
+     * @brief 启用设备状态推送通道
+     * @param path WebSocket路径
+     * @param config 推送配置
+     * @return 启用是否成功
+     */
+    bool enableTelemetry(
+        const char* path = "/ws/telemetry", const TelemetryChannel::Config& config = {}
+    ) {
+        if (!isInitialized || !server) {
+            ESP_LOGE(TAG, "Web server not initialized");
+            return false;
+        }
+
+        if (xSemaphoreTake(mutex, portMAX_DELAY) == pdTRUE) {
+            if (telemetry) {
+                ESP_LOGW(TAG, "Telemetry already enabled");
+                xSemaphoreGive(mutex);
+                return true;
+            }
+
+            telemetry = std::make_unique<TelemetryChannel>(path);
+            server->addHandler(telemetry->handler());
+            bool success = telemetry->start(config);
+            xSemaphoreGive(mutex);
+            return success;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 添加推送数据源
+     * @param key 消息中的字段名
+     * @param source 数据源回调
+     */
+    void addTelemetrySource(const char* key, TelemetryChannel::Source source) {
+        if (!telemetry) {
+            ESP_LOGE(TAG, "Telemetry not enabled");
+            return;
+        }
+
+        telemetry->addSource(key, std::move(source));
+    }
+
+    /**
+     * @brief 获取推送通道
+     * @return 未启用时返回nullptr
+     */
+    TelemetryChannel* getTelemetry() {
+        return telemetry.get();
+    }
+
     /**
      * @brief 启动服务器
      */
@@ -125,6 +480,7 @@ class WebServerController {
                 return;
             }
             server->begin();
+            isStarted = true;
             ESP_LOGI(TAG, "Web server started");
             xSemaphoreGive(mutex);
         }
@@ -141,11 +497,19 @@ class WebServerController {
                 return;
             }
             server->end();
+            isStarted = false;
             ESP_LOGI(TAG, "Web server stopped");
             xSemaphoreGive(mutex);
         }
     }
 
+    /**
+     * @brief 服务器是否已启动并在监听
+     */
+    bool isRunning() const {
+        return isStarted;
+    }
+
     /**
      * @brief 析构函数
      */
@@ -160,6 +524,272 @@ class WebServerController {
     }
 
    private:
+    /**
+     * @brief 请求体缓冲区，保存在request->_tempObject中，由请求析构时free()
+     */
+    struct RequestBody {
+        size_t length;    // 请求体总长度
+        size_t received;  // 已接收长度
+        bool overflow;    // 是否超过大小上限
+        uint8_t data[];   // 请求体内容
+    };
+
+    /**
+     * @brief 过滤器解析出的资源，保存在request->_tempObject中，由请求析构时free()
+     */
+    struct ResolvedAsset {
+        AssetManifest::Info info;  // 清单信息
+        bool plain;                // 未压缩的文件是否存在
+        char path[];               // 文件路径
+    };
+
+    /**
+     * @brief 校验已接收的请求体并调用处理函数
+     */
+    template <typename Handler>
+    static void invokeWithBody(AsyncWebServerRequest* request, const Handler& handler) {
+        auto* body = static_cast<RequestBody*>(request->_tempObject);
+        if (!body && request->contentLength() > 0) {
+            sendText(request, 503, "text/plain", "Out of memory");
+            return;
+        }
+        if (body && body->overflow) {
+            sendText(request, 413, "text/plain", "Payload Too Large");
+            return;
+        }
+        if (body && body->received != body->length) {
+            sendText(request, 400, "text/plain", "Incomplete body");
+            return;
+        }
+        handler(request, body ? body->data : nullptr, body ? body->length : 0);
+    }
+
+    /**
+     * @brief 404处理
+     */
+    void handleNotFound(AsyncWebServerRequest* request) {
+        admission.tag(request, notFoundRoute);
+        if (notFoundHandler) {
+            notFoundHandler(request);
+        } else {
+            // 默认404处理：尝试发送404.html，如果不存在则发送简单文本
+            AsyncWebServerResponse* page =
+                notFoundPageExists() ? beginFileResponse(request, NOT_FOUND_PAGE, "text/html") : nullptr;
+            if (page) {
+                request->send(page);
+            } else {
+                sendText(request, 404, "text/plain", "404");
+            }
+        }
+    }
+
+    /**
+     * @brief 默认404页面是否存在
+     * @details 结果按根目录代数缓存，任何文件写入或重新挂载后才重新检查一次
+     */
+    bool notFoundPageExists() {
+        LittleFSController& fs = LittleFSController::getInstance();
+        uint32_t generation = fs.getDirGeneration("/");
+        if (generation != notFoundGeneration) {
+            notFoundGeneration = generation;
+            hasNotFoundPage = fs.exists(NOT_FOUND_PAGE);
+        }
+        return hasNotFoundPage;
+    }
+
+    /**
+     * @brief 创建通过LittleFSController读取器发送文件的响应
+     * @details 每次读取持有文件系统共享锁；响应未结束时读取器保持打开，卸载文件系统会等待其结束
+     * @param request 请求
+     * @param path 文件路径
+     * @param contentType Content-Type
+     * @return 响应，文件打开失败时为nullptr
+     */
+    static AsyncWebServerResponse* beginFileResponse(
+        AsyncWebServerRequest* request, const char* path, const char* contentType
+    ) {
+        auto reader = std::make_shared<LittleFSController::Reader>(
+            LittleFSController::getInstance().openReader(path)
+        );
+        if (!*reader) {
+            return nullptr;
+        }
+
+        size_t size = reader->size();
+        return request->beginResponse(
+            contentType,
+            size,
+            [request, reader, size](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                size_t n = index < size ? reader->read(buffer, std::min(maxLen, size - index)) : 0;
+                if (n == 0 || index + n >= size) {
+                    reader->close();  // 读完即关闭，不等客户端确认
+                }
+                if (n > 0) {
+                    countBytesOut(request, n);
+                }
+                return n;
+            }
+        );
+    }
+
+    /**
+     * @brief 把请求路径映射为Web根目录中的文件并从资源清单查询，不访问flash
+     * @param url 请求路径
+     * @param path 输出文件路径，目录映射为其中的默认文件
+     * @param info 输出清单信息；只有压缩版本时为压缩版本的信息，MIME类型按原文件名确定
+     * @param plain 输出未压缩的文件是否存在
+     * @return 是否有可发送的文件
+     */
+    bool resolveAsset(const char* url, std::string& path, AssetManifest::Info& info, bool& plain) {
+        LittleFSController& fs = LittleFSController::getInstance();
+        path = assetRoot;
+        path += url;
+
+        bool found = fs.getAssetInfo(path.c_str(), info);
+        if (path.back() == '/' || (found && info.isDirectory)) {
+            if (path.back() != '/') {
+                path += '/';
+            }
+            path += DEFAULT_FILE;
+            found = fs.getAssetInfo(path.c_str(), info);
+        }
+
+        plain = found && !info.isDirectory;
+        if (plain) {
+            return true;
+        }
+
+        AssetManifest::Info gzip;
+        if (!fs.getAssetInfo((path + AssetManifest::GZIP_SUFFIX).c_str(), gzip)) {
+            return false;
+        }
+        info = gzip;
+        info.mimeType = fs.getMimeType(path.c_str());
+        info.hasGzip = true;
+        info.gzipSize = gzip.size;
+        return true;
+    }
+
+    /**
+     * @brief 把过滤器的解析结果保存到请求上，供serveAsset()使用；分配失败时serveAsset()重新解析
+     */
+    static void stashAsset(
+        AsyncWebServerRequest* request, const std::string& path, const AssetManifest::Info& info, bool plain
+    ) {
+        if (request->_tempObject != nullptr) {
+            return;
+        }
+        auto* resolved = static_cast<ResolvedAsset*>(malloc(sizeof(ResolvedAsset) + path.size() + 1));
+        if (resolved == nullptr) {
+            return;
+        }
+        resolved->info = info;
+        resolved->plain = plain;
+        memcpy(resolved->path, path.c_str(), path.size() + 1);
+        request->_tempObject = resolved;
+    }
+
+    /**
+     * @brief 发送Web根目录中的静态文件
+     * @details Content-Type和ETag来自资源清单；有压缩版本且客户端接受gzip时发送".gz"文件，
+     *          并添加Content-Encoding
+     */
+    void serveAsset(AsyncWebServerRequest* request) {
+        std::string path;
+        AssetManifest::Info info;
+        bool plain;
+        if (auto* resolved = static_cast<ResolvedAsset*>(request->_tempObject)) {
+            path = resolved->path;
+            info = resolved->info;
+            plain = resolved->plain;
+        } else if (!resolveAsset(request->url().c_str(), path, info, plain)) {
+            handleNotFound(request);
+            return;
+        }
+
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"%08x\"", info.etag);
+        if (request->hasHeader("If-None-Match") && request->header("If-None-Match") == etag) {
+            AsyncWebServerResponse* response = request->beginResponse(304);
+            response->addHeader("ETag", etag);
+            response->addHeader("Cache-Control", CACHE_CONTROL);
+            request->send(response);
+            return;
+        }
+
+        bool gzip = info.hasGzip &&
+                    (!plain || (request->hasHeader("Accept-Encoding") &&
+                                request->header("Accept-Encoding").indexOf("gzip") >= 0));
+        if (gzip) {
+            path += AssetManifest::GZIP_SUFFIX;
+        }
+
+        AsyncWebServerResponse* response = beginFileResponse(request, path.c_str(), info.mimeType);
+        if (!response) {
+            ESP_LOGE(TAG, "Failed to open asset: %s", path.c_str());
+            handleNotFound(request);
+            return;
+        }
+
+        if (gzip) {
+            response->addHeader("Content-Encoding", "gzip");
+        }
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", CACHE_CONTROL);
+        request->send(response);
+    }
+
+    /**
+     * @brief 累加请求的响应字节数，请求结束时计入路由指标
+     */
+    static void countBytesOut(AsyncWebServerRequest* request, size_t bytes) {
+        getInstance().admission.addBytesOut(request, bytes);
+    }
+
+    /**
+     * @brief 创建为请求打上路由指标标签的过滤器
+     * @details 处理器按注册顺序依次执行过滤器和匹配，最终处理请求的处理器最后打标签
+     */
+    ArRequestFilterFunction routeTagger(int route) {
+        return [this, route](AsyncWebServerRequest* request) {
+            admission.tag(request, route);
+            return true;
+        };
+    }
+
+    /**
+     * @brief 将分段到达的请求体拼接到一块预分配的缓冲区
+     */
+    static void collectBody(
+        AsyncWebServerRequest* request,
+        const uint8_t* data,
+        size_t len,
+        size_t index,
+        size_t total,
+        size_t maxBodySize
+    ) {
+        if (index == 0 && request->_tempObject == nullptr) {
+            bool overflow = total > maxBodySize;
+            size_t capacity = overflow ? 0 : total;
+            auto* body = static_cast<RequestBody*>(malloc(sizeof(RequestBody) + capacity));
+            if (body == nullptr) {
+                ESP_LOGE(TAG, "Failed to allocate %u bytes for request body", total);
+                return;
+            }
+            body->length = capacity;
+            body->received = 0;
+            body->overflow = overflow;
+            request->_tempObject = body;
+        }
+
+        auto* body = static_cast<RequestBody*>(request->_tempObject);
+        if (body == nullptr || body->overflow || index + len > body->length) {
+            return;
+        }
+        memcpy(body->data + index, data, len);
+        body->received += len;
+    }
+
     /**
      * @brief 构造函数（私有）
      */
@@ -172,7 +802,15 @@ class WebServerController {
     WebServerController& operator=(const WebServerController&) = delete;
 
     bool isInitialized = false;                         // 服务器是否已初始化
+    bool isStarted = false;                             // 服务器是否已启动
     std::unique_ptr<AsyncWebServer> server;             // Web服务器实例
     RequestHandler notFoundHandler;                     // 404处理器
+    bool hasNotFoundPage = false;                       // 默认404页面是否存在
+    uint32_t notFoundGeneration = 0;                    // hasNotFoundPage对应的根目录代数
+    std::string assetRoot;                              // Web根目录，不以'/'结尾
+    std::unique_ptr<TelemetryChannel> telemetry;        // 状态推送通道
+    AdmissionControl admission;                         // 请求准入控制
+    RouteMetrics metrics;                               // 路由指标
+    int notFoundRoute = -1;                             // 404的路由指标下标
     SemaphoreHandle_t mutex = xSemaphoreCreateMutex();  // 互斥锁
 };
\ No newline at end of file
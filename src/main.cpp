@@ -5,13 +5,27 @@
 #include <time.h>
 #include <ButtonController.hpp>
 // #include <DNSServer.hpp>
+#include <DeviceTelemetry.hpp>
+#include <FsImageUpdater.hpp>
+#include <KvStore.hpp>
+#include <LedApi.hpp>
+#include <LedController.hpp>
 #include <LedPresetManager.hpp>
+#include <LedPreview.hpp>
+#include <LittleFSBenchmark.hpp>
 #include <LittleFSController.hpp>
 #include <MdnsController.hpp>
+#include <OtaApi.hpp>
 #include <OtaController.hpp>
+#include <OtaHealthCheck.hpp>
 #include <TimeManager.hpp>
 #include <WebServerController.hpp>
 
+// 新固件的有效性由OtaHealthCheck自检后确认，不在启动时自动确认
+extern "C" bool verifyRollbackLater() {
+    return true;
+}
+
 void setup() {
     esp_log_level_set("*", ESP_LOG_DEBUG);
     const char* LOG_TAG = "SETUP";
@@ -38,10 +52,21 @@ void setup() {
     ESP_LOGD(LOG_TAG, "CPU freq: %d MHz", ESP.getCpuFreqMHz());
 
     // 初始化文件系统
+    // 挂载失败时不能提前返回，否则下面的自检不会启动，新固件会一直处于待验证状态而不回滚
+    // 上次镜像写入未完成时分区内容不完整，不格式化，保留分区等待重新上传镜像
     auto& fs = LittleFSController::getInstance();
-    if (!fs.init()) {
+    LittleFSController::Config fsConfig;
+    fsConfig.formatOnFail = !FsImageUpdater::imageWritePending();
+    bool fsReady = fs.init(fsConfig);
+    if (!fsReady) {
         ESP_LOGE("SETUP", "Failed to initialize filesystem");
-        return;
+    }
+    // LittleFSBenchmark::run();
+    // LittleFSBenchmark::runSuite();
+
+    // 加载键值配置
+    if (fsReady) {
+        KvStore::getInstance().begin();
     }
 
     // 初始化OTA
@@ -76,6 +101,15 @@ void setup() {
     // if (web.init()) {
     //     web.start();
     //     ESP_LOGI("SETUP", "Web server started successfully");
+    //     if (web.enableTelemetry()) {
+    //         DeviceTelemetry::registerSources(web);
+    //     }
+    //     LedPreview::getInstance().init(web, "/ws/led", 10);
+    //     LedApi::registerRoutes(web);
+    //     OtaApi::registerRoutes(web);
+    //     web.addHeapStatsHandler();
+    //     web.addMetricsHandler();
+    //     web.setRouteLimit("/api/led", 2);
     //     web.addApiHandler(
     //         "/api/test",
     //         WebRequestMethod::HTTP_GET,
@@ -106,6 +140,14 @@ void setup() {
         },
         2000
     );
+
+    // 新固件首次启动时自检，全部通过后确认固件，否则回滚
+    auto& health = OtaHealthCheck::getInstance();
+    health.addCheck("fs", []() { return LittleFSController::getInstance().isMounted(); }, 1000);
+    health.addCheck("led", []() { return LedController::getInstance().isAlive(); }, 3000);
+    // Web服务器启用后再加入检查；isRunning()只表示已调用start()，不代表能处理请求
+    health.addCheck("heap", OtaHealthCheck::heapFloor(32 * 1024), 5000);
+    health.start();
 }
 
 void loop() {
@@ -0,0 +1,79 @@
+"""
+LittleFS性能测试结果比较工具
+
+从串口日志中提取 lib/LittleFS/LittleFSBenchmark.hpp 的 runSuite() 输出的 "BENCH {json}" 行，
+比较两次运行（不同固件版本或挂载参数）的平均耗时。sweep() 的结果在同一份日志中按标签区分，
+可用 --before-label/--after-label 选择要比较的两组。
+
+用法：
+    pio device monitor | tee before.log
+    python tools/fs_bench.py before.log after.log
+    python tools/fs_bench.py before.log after.log --threshold 10
+    python tools/fs_bench.py sweep.log sweep.log --before-label files10_ra1_psram --after-label files10_ra8_psram
+"""
+
+from pathlib import Path
+import argparse
+import json
+import sys
+
+MARKER = 'BENCH '
+
+
+def load(path, label=None):
+    """
+    读取日志中的测试结果
+
+    Args:
+        path: 日志文件
+        label: 只读取该标签的结果，None表示全部
+
+    Returns:
+        {(test, size): result}，同一项出现多次时取最后一次
+    """
+    results = {}
+    for line in path.read_text(errors='replace').splitlines():
+        pos = line.find(MARKER + '{')
+        if pos < 0:
+            continue
+        try:
+            result = json.loads(line[pos + len(MARKER):].strip())
+        except json.JSONDecodeError:
+            continue
+        if label is None or result.get('label') == label:
+            results[(result['test'], result['size'])] = result
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description='LittleFS性能测试结果比较工具')
+    parser.add_argument('before', type=Path, help='基准日志')
+    parser.add_argument('after', type=Path, help='对比日志')
+    parser.add_argument('--before-label', help='只比较基准日志中该标签的结果')
+    parser.add_argument('--after-label', help='只比较对比日志中该标签的结果')
+    parser.add_argument('--threshold', type=float, default=20, help='平均耗时增加超过该百分比时视为退化')
+    args = parser.parse_args()
+
+    before = load(args.before, args.before_label)
+    after = load(args.after, args.after_label)
+    if not before or not after:
+        sys.exit('No BENCH results found')
+
+    regressions = 0
+    print(f'{"test":<22}{"size":>8}{"before us":>12}{"after us":>12}{"change":>10}')
+    for key in sorted(before.keys() & after.keys()):
+        old = before[key]['avg_us']
+        new = after[key]['avg_us']
+        change = 100 * (new - old) / old if old else 0
+        flag = ''
+        if change > args.threshold:
+            flag = '  REGRESSION'
+            regressions += 1
+        print(f'{key[0]:<22}{key[1]:>8}{old:>12}{new:>12}{change:>9.1f}%{flag}')
+
+    if regressions:
+        sys.exit(f'{regressions} regressions above {args.threshold}%')
+
+
+if __name__ == '__main__':
+    main()
\ No newline at end of file
@@ -0,0 +1,205 @@
+"""
+差分升级补丁工具
+
+生成相对当前运行固件的差分补丁，补丁格式与 lib/OTA/DeltaPatcher.hpp 一致。
+
+用法：
+    python tools/ota_delta.py diff old.bin new.bin firmware.patch
+    python tools/ota_delta.py apply old.bin firmware.patch out.bin
+    curl --data-binary @firmware.patch -H "X-Firmware-SHA256: $(sha256sum new.bin | cut -c1-64)" http://<device>/api/ota
+"""
+
+from pathlib import Path
+import argparse
+import gzip
+import hashlib
+import struct
+import sys
+
+MAGIC = b'DOTA'
+VERSION = 1
+HEADER = struct.Struct('<4sB3xII32s')
+CONTROL = struct.Struct('<IIi')
+
+SEED_LENGTH = 16    # 种子匹配长度
+INDEX_STRIDE = 4    # 旧镜像索引步长，长度不小于 SEED_LENGTH + INDEX_STRIDE - 1 的匹配都能被找到
+MAX_CANDIDATES = 8  # 每个种子最多尝试的旧镜像位置
+
+
+def build_index(source):
+    """
+    按固定步长索引旧镜像中的种子
+
+    Args:
+        source: 旧镜像
+    """
+    index = {}
+    for pos in range(0, len(source) - SEED_LENGTH + 1, INDEX_STRIDE):
+        candidates = index.setdefault(source[pos:pos + SEED_LENGTH], [])
+        if len(candidates) < MAX_CANDIDATES:
+            candidates.append(pos)
+    return index
+
+
+def extend_forward(source, target, src, dst):
+    """
+    向后做近似扩展（bsdiff方式）：保留使“匹配数*2 - 长度”最大的长度，
+    使地址偏移等少量字节不同的代码仍可作为差分数据
+    """
+    limit = min(len(source) - src, len(target) - dst)
+    score = best_score = best = 0
+    for i in range(limit):
+        score += 1 if source[src + i] == target[dst + i] else -1
+        if score > best_score:
+            best_score, best = score, i + 1
+        elif score < best_score - 2 * SEED_LENGTH:
+            break
+    return best
+
+
+def extend_backward(source, target, src, dst, limit):
+    """
+    向前做近似扩展，最多扩展到 limit 字节（不与上一段重叠）
+    """
+    limit = min(limit, src)
+    score = best_score = best = 0
+    for i in range(1, limit + 1):
+        score += 1 if source[src - i] == target[dst - i] else -1
+        if score > best_score:
+            best_score, best = score, i
+        elif score < best_score - 2 * SEED_LENGTH:
+            break
+    return best
+
+
+def find_matches(source, target):
+    """
+    贪心查找匹配段
+
+    Returns:
+        [(目标位置, 旧镜像位置, 长度)]，按目标位置递增且互不重叠
+    """
+    index = build_index(source)
+    matches = []
+    covered = 0      # 目标镜像已被匹配覆盖到的位置
+    last_delta = 0   # 上一段的 旧镜像位置 - 目标位置，优先沿用
+    dst = 0
+    while dst <= len(target) - SEED_LENGTH:
+        seed = target[dst:dst + SEED_LENGTH]
+        candidates = index.get(seed)
+        if not candidates:
+            dst += 1
+            continue
+
+        # 优先选择与上一段偏移相同的位置，其次选择向后扩展最长的位置
+        best = None
+        for src in candidates:
+            length = extend_forward(source, target, src, dst)
+            key = (src - dst == last_delta, length)
+            if best is None or key > best[0]:
+                best = (key, src, length)
+        _, src, length = best
+
+        back = extend_backward(source, target, src, dst, dst - covered)
+        matches.append((dst - back, src - back, length + back))
+        last_delta = src - dst
+        covered = dst = dst + length
+    return matches
+
+
+def make_patch(source, target):
+    """
+    生成未压缩的补丁
+
+    Args:
+        source: 旧镜像
+        target: 新镜像
+    """
+    out = bytearray(HEADER.pack(MAGIC, VERSION, len(source), len(target), hashlib.sha256(source).digest()))
+    matches = find_matches(source, target)
+
+    # 每条记录为：差分段、随后的新增段、移动到下一段的旧镜像位置
+    first_dst, first_src = (matches[0][0], matches[0][1]) if matches else (len(target), 0)
+    out += CONTROL.pack(0, first_dst, first_src)
+    out += target[:first_dst]
+
+    for i, (dst, src, length) in enumerate(matches):
+        next_dst, next_src = (matches[i + 1][0], matches[i + 1][1]) if i + 1 < len(matches) else (len(target), src + length)
+        out += CONTROL.pack(length, next_dst - dst - length, next_src - src - length)
+        out += bytes((target[dst + j] - source[src + j]) & 0xFF for j in range(length))
+        out += target[dst + length:next_dst]
+    return bytes(out)
+
+
+def apply_patch(source, patch):
+    """
+    应用补丁（与设备端逻辑相同，用于校验）
+
+    Args:
+        source: 旧镜像
+        patch: 补丁，可以是gzip压缩的
+    """
+    if patch[:2] == b'\x1f\x8b':
+        patch = gzip.decompress(patch)
+
+    magic, version, source_size, target_size, source_sha = HEADER.unpack_from(patch)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError('unsupported patch format')
+    if hashlib.sha256(source[:source_size]).digest() != source_sha:
+        raise ValueError('patch was built against a different firmware')
+
+    target = bytearray()
+    pos = HEADER.size
+    src = 0
+    while pos < len(patch):
+        diff_length, extra_length, seek = CONTROL.unpack_from(patch, pos)
+        pos += CONTROL.size
+        target += bytes((source[src + j] + patch[pos + j]) & 0xFF for j in range(diff_length))
+        pos += diff_length
+        src += diff_length
+        target += patch[pos:pos + extra_length]
+        pos += extra_length
+        src += seek
+    if len(target) != target_size:
+        raise ValueError('incomplete patch')
+    return bytes(target)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='差分升级补丁工具')
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    diff = commands.add_parser('diff', help='生成补丁')
+    diff.add_argument('old', type=Path, help='设备当前运行的固件')
+    diff.add_argument('new', type=Path, help='新固件')
+    diff.add_argument('patch', type=Path, help='输出的补丁')
+    diff.add_argument('--no-gzip', action='store_true', help='不压缩补丁')
+
+    apply = commands.add_parser('apply', help='应用补丁')
+    apply.add_argument('old', type=Path, help='旧固件')
+    apply.add_argument('patch', type=Path, help='补丁')
+    apply.add_argument('new', type=Path, help='输出的新固件')
+
+    args = parser.parse_args()
+    source = args.old.read_bytes()
+
+    if args.command == 'apply':
+        args.new.write_bytes(apply_patch(source, args.patch.read_bytes()))
+        return
+
+    target = args.new.read_bytes()
+    patch = make_patch(source, target)
+    if not args.no_gzip:
+        patch = gzip.compress(patch, 9)
+
+    # 写出前自检，避免上传无法还原的补丁
+    if apply_patch(source, patch) != target:
+        sys.exit('Patch self-check failed')
+
+    args.patch.write_bytes(patch)
+    print(f'Patch: {len(patch)} bytes, {100 * len(patch) / len(target):.1f}% of {len(target)} bytes')
+    print(f'SHA-256: {hashlib.sha256(target).hexdigest()}')
+
+
+if __name__ == '__main__':
+    main()
\ No newline at end of file
@@ -0,0 +1,68 @@
+"""
+拉取升级测试服务器
+
+提供单个固件文件，支持Range/If-Range和ETag，可以模拟下载中断，用于测试 POST /api/ota/pull 的断点续传。
+
+用法：
+    python tools/ota_server.py .pio/build/esp32-s3-devkitc-1/firmware.bin --port 8000 --drop-after 300000
+    curl -X POST http://<device>/api/ota/pull -d '{"url": "http://<host>:8000/firmware.bin"}'
+"""
+
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+import argparse
+import hashlib
+import re
+
+
+def make_handler(image, drop_after):
+    """
+    创建请求处理器
+
+    Args:
+        image: 固件内容
+        drop_after: 每个响应最多发送的字节数，之后断开连接，0表示不断开
+    """
+    etag = '"' + hashlib.sha256(image).hexdigest()[:16] + '"'
+
+    class Handler(BaseHTTPRequestHandler):
+        def do_GET(self):
+            start = 0
+            match = re.fullmatch(r'bytes=(\d+)-', self.headers.get('Range', ''))
+            if_range = self.headers.get('If-Range')
+            if match and (if_range is None or if_range == etag) and int(match[1]) < len(image):
+                start = int(match[1])
+                self.send_response(206)
+                self.send_header('Content-Range', f'bytes {start}-{len(image) - 1}/{len(image)}')
+            else:
+                self.send_response(200)
+
+            self.send_header('Content-Type', 'application/octet-stream')
+            self.send_header('Content-Length', str(len(image) - start))
+            self.send_header('Accept-Ranges', 'bytes')
+            self.send_header('ETag', etag)
+            self.end_headers()
+
+            end = len(image) if drop_after == 0 else min(len(image), start + drop_after)
+            self.wfile.write(image[start:end])
+            if end < len(image):
+                self.log_message('dropped connection at %d of %d bytes', end, len(image))
+                self.close_connection = True
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(description='拉取升级测试服务器')
+    parser.add_argument('image', type=Path, help='固件文件')
+    parser.add_argument('--port', type=int, default=8000, help='端口')
+    parser.add_argument('--drop-after', type=int, default=0, help='每个响应发送多少字节后断开，模拟下载中断')
+    args = parser.parse_args()
+
+    image = args.image.read_bytes()
+    print(f'Serving {args.image} ({len(image)} bytes), sha256: {hashlib.sha256(image).hexdigest()}')
+    ThreadingHTTPServer(('', args.port), make_handler(image, args.drop_after)).serve_forever()
+
+
+if __name__ == '__main__':
+    main()
\ No newline at end of file